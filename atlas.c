@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/Xutil.h>
+
+#include "atlas.h"
+
+static int AtlasRows(int frameHeight, int nFrames) {
+  int rows = MAX_ATLAS_SIZE / frameHeight;
+
+  return (rows > nFrames ? nFrames : rows);
+}
+
+/*
+ *  AtlasSize - The size of the pixmap an atlas of nFrames needs.
+ */
+void AtlasSize(int frameWidth, int frameHeight, int nFrames, int *width,
+               int *height) {
+  int rows = AtlasRows(frameHeight, nFrames);
+
+  *width = (nFrames + rows - 1) / rows * frameWidth;
+  *height = rows * frameHeight;
+}
+
+FrameAtlas *AtlasCreate(Display *dpy, Drawable drawable, int frameWidth,
+                        int frameHeight, int nFrames) {
+  return (AtlasCreateColored(dpy, drawable, (Visual *)NULL, 1, 1, 0,
+                             frameWidth, frameHeight, nFrames));
+}
+
+/*
+ *  AtlasCreateColored - An atlas of depth, whose frames are uploaded
+ *  with set bits in fg and clear bits in bg, exactly as CopyPlane would
+ *  show them through a GC with those colors.  visual is the one the
+ *  pixel values belong to.
+ */
+FrameAtlas *AtlasCreateColored(Display *dpy, Drawable drawable,
+                               Visual *visual, int depth, unsigned long fg,
+                               unsigned long bg, int frameWidth,
+                               int frameHeight, int nFrames) {
+  FrameAtlas *atlas;
+  XGCValues gcv;
+  int width, height;
+
+  atlas = (FrameAtlas *)malloc(sizeof(FrameAtlas));
+  atlas->nFrames = nFrames;
+  atlas->frameWidth = frameWidth;
+  atlas->frameHeight = frameHeight;
+  atlas->rows = AtlasRows(frameHeight, nFrames);
+  atlas->loaded = (char *)calloc(nFrames, 1);
+  atlas->shared = False;
+  atlas->depth = depth;
+  atlas->visual = visual;
+  atlas->fg = fg;
+  atlas->bg = bg;
+
+  AtlasSize(frameWidth, frameHeight, nFrames, &width, &height);
+  atlas->pixmap = XCreatePixmap(dpy, drawable, width, height, depth);
+
+  gcv.graphics_exposures = False;
+  atlas->gc = XCreateGC(dpy, atlas->pixmap, GCGraphicsExposures, &gcv);
+
+  return (atlas);
+}
+
+/*
+ *  AtlasWrap - An atlas around a pixmap of depth someone else filled
+ *  with all nFrames frames.  It is never written to, and not freed with
+ *  it.
+ */
+FrameAtlas *AtlasWrap(Pixmap pixmap, int depth, int frameWidth,
+                      int frameHeight, int nFrames) {
+  FrameAtlas *atlas;
+
+  atlas = (FrameAtlas *)malloc(sizeof(FrameAtlas));
+  atlas->pixmap = pixmap;
+  atlas->nFrames = nFrames;
+  atlas->frameWidth = frameWidth;
+  atlas->frameHeight = frameHeight;
+  atlas->rows = AtlasRows(frameHeight, nFrames);
+  atlas->loaded = (char *)malloc(nFrames);
+  memset(atlas->loaded, 1, nFrames);
+  atlas->gc = (GC)NULL;
+  atlas->shared = True;
+  atlas->depth = depth;
+  atlas->visual = (Visual *)NULL;
+  atlas->fg = 1;
+  atlas->bg = 0;
+
+  return (atlas);
+}
+
+void AtlasDestroy(Display *dpy, FrameAtlas *atlas) {
+  if (atlas) {
+    if (atlas->gc != NULL) {
+      XFreeGC(dpy, atlas->gc);
+    }
+    if (!atlas->shared) {
+      XFreePixmap(dpy, atlas->pixmap);
+    }
+    free(atlas->loaded);
+    free(atlas);
+  }
+}
+
+/*
+ *  PutColored - Uploads bitmap into the slot at x, y of a colored
+ *  atlas, expanded to fg and bg on the client side.  The pixels go as
+ *  32 bits in host order; Xlib converts if the server wants otherwise.
+ */
+static void PutColored(Display *dpy, FrameAtlas *atlas, int x, int y,
+                       const RasterBitmap *bitmap) {
+  RasterImage *colored;
+  XImage *image;
+
+  colored = RasterImageCreate(atlas->frameWidth, atlas->frameHeight);
+  RasterCopyPlane(colored, bitmap, 0, 0, colored->width, colored->height, 0,
+                  0, atlas->fg, atlas->bg);
+
+  image = XCreateImage(dpy, atlas->visual, atlas->depth, ZPixmap, 0,
+                       (char *)colored->pixels, colored->width,
+                       colored->height, 32,
+                       colored->stride * sizeof(uint32_t));
+  image->bits_per_pixel = 32;
+  image->byte_order = RasterHostByteOrder();
+  XInitImage(image);
+
+  XPutImage(dpy, atlas->pixmap, atlas->gc, image, 0, 0, x, y,
+            atlas->frameWidth, atlas->frameHeight);
+
+  image->data = NULL;
+  XDestroyImage(image);
+  RasterImageDestroy(colored);
+}
+
+/*
+ *  AtlasPut - Uploads bitmap into the slot for frame.  For a 1-bit
+ *  atlas the bitmap is described in place, the way
+ *  XCreateBitmapFromData does it, so nothing is copied on the client
+ *  side.
+ */
+void AtlasPut(Display *dpy, FrameAtlas *atlas, int frame,
+              const RasterBitmap *bitmap) {
+  XImage image;
+  int x, y;
+
+  if (atlas->depth > 1) {
+    AtlasOrigin(atlas, frame, &x, &y);
+    PutColored(dpy, atlas, x, y, bitmap);
+    atlas->loaded[frame] = 1;
+    return;
+  }
+
+  image.width = bitmap->width;
+  image.height = bitmap->height;
+  image.xoffset = 0;
+  image.format = XYPixmap;
+  image.data = (char *)bitmap->bits;
+  image.byte_order = LSBFirst;
+  image.bitmap_unit = 8;
+  image.bitmap_bit_order = LSBFirst;
+  image.bitmap_pad = 8;
+  image.depth = 1;
+  image.bytes_per_line = bitmap->stride;
+  image.bits_per_pixel = 1;
+  image.red_mask = image.green_mask = image.blue_mask = 0;
+  image.obdata = NULL;
+  XInitImage(&image);
+
+  AtlasOrigin(atlas, frame, &x, &y);
+  XPutImage(dpy, atlas->pixmap, atlas->gc, &image, 0, 0, x, y,
+            atlas->frameWidth, atlas->frameHeight);
+  atlas->loaded[frame] = 1;
+}
+
+/*
+ *  AtlasOrigin - Where frame sits in the atlas pixmap.
+ */
+void AtlasOrigin(const FrameAtlas *atlas, int frame, int *x, int *y) {
+  *x = (frame / atlas->rows) * atlas->frameWidth;
+  *y = (frame % atlas->rows) * atlas->frameHeight;
+}
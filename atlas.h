@@ -0,0 +1,54 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <X11/Xlib.h>
+
+#include "raster.h"
+
+/*
+ *  Sprite atlas: every frame of one animation packed into a single
+ *  server pixmap, so a frame is a source offset rather than a pixmap
+ *  of its own.  The pixmap is 1-bit, to be shown with CopyPlane, or
+ *  already colored at the window's depth, to be shown with CopyArea.
+ *  Frames are stacked top to bottom and wrap into further columns
+ *  before the pixmap would exceed the protocol's 16-bit size limit.
+ *  Slots start out empty and are filled as frames are rendered, unless
+ *  the atlas wraps a complete pixmap from the shared frame cache.
+ */
+#define MAX_ATLAS_SIZE 32767 /*  Largest pixmap side  */
+
+typedef struct {
+  Pixmap pixmap;
+  int nFrames;
+  int frameWidth;
+  int frameHeight;
+  int rows;     /*  Frames per column  */
+  char *loaded; /*  Slot filled yet?   */
+  GC gc;        /*  For every upload   */
+  Bool shared;  /*  Pixmap not ours    */
+
+  int depth;        /*  1 or the window's  */
+  Visual *visual;   /*  Colored atlases:   */
+  unsigned long fg; /*  set bits           */
+  unsigned long bg; /*  clear bits         */
+} FrameAtlas;
+
+FrameAtlas *AtlasCreate(Display *dpy, Drawable drawable, int frameWidth,
+                        int frameHeight, int nFrames);
+FrameAtlas *AtlasCreateColored(Display *dpy, Drawable drawable,
+                               Visual *visual, int depth, unsigned long fg,
+                               unsigned long bg, int frameWidth,
+                               int frameHeight, int nFrames);
+FrameAtlas *AtlasWrap(Pixmap pixmap, int depth, int frameWidth,
+                      int frameHeight, int nFrames);
+void AtlasDestroy(Display *dpy, FrameAtlas *atlas);
+void AtlasSize(int frameWidth, int frameHeight, int nFrames, int *width,
+               int *height);
+
+void AtlasPut(Display *dpy, FrameAtlas *atlas, int frame,
+              const RasterBitmap *bitmap);
+void AtlasOrigin(const FrameAtlas *atlas, int frame, int *x, int *y);
+
+#define AtlasLoaded(a, frame) ((a)->loaded[frame])
+
+#endif
@@ -0,0 +1,37 @@
+#include <X11/Xlib.h>
+#include <X11/extensions/dpms.h>
+#include <X11/extensions/scrnsaver.h>
+
+#include "blank.h"
+
+/*
+ *  BlankQuery - True while the screen saver is on or the monitor is in
+ *  any DPMS state but on.  The extension queries are answered from
+ *  Xlib's per display cache after the first time; the state queries
+ *  cost a round trip each.
+ */
+Bool BlankQuery(Display *dpy) {
+  static XScreenSaverInfo *saverInfo = (XScreenSaverInfo *)NULL;
+  int eventBase, errorBase;
+
+  if (XScreenSaverQueryExtension(dpy, &eventBase, &errorBase)) {
+    if (saverInfo == NULL) {
+      saverInfo = XScreenSaverAllocInfo();
+    }
+    if (XScreenSaverQueryInfo(dpy, DefaultRootWindow(dpy), saverInfo) &&
+        saverInfo->state == ScreenSaverOn) {
+      return (True);
+    }
+  }
+
+  if (DPMSQueryExtension(dpy, &eventBase, &errorBase)) {
+    CARD16 level;
+    BOOL enabled;
+
+    if (DPMSInfo(dpy, &level, &enabled) && enabled && level != DPMSModeOn) {
+      return (True);
+    }
+  }
+
+  return (False);
+}
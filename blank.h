@@ -0,0 +1,17 @@
+#ifndef BLANK_H
+#define BLANK_H
+
+#include <X11/Xlib.h>
+
+/*
+ *  Screen blanking.
+ *
+ *  Asks MIT-SCREEN-SAVER whether the screen saver is active and DPMS
+ *  whether the monitor is powered down.  Either extension may be
+ *  missing, in which case it simply never reports the screen blanked.
+ */
+#define BLANK_POLL_INTERVAL 5000 /*  Milliseconds between polls  */
+
+Bool BlankQuery(Display *dpy);
+
+#endif
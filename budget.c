@@ -0,0 +1,100 @@
+#include "budget.h"
+
+void BudgetInit(Budget *budget, int nLevels, double bytesPerSecond) {
+  budget->levels = nLevels;
+  budget->average = 0.0;
+  BudgetSet(budget, bytesPerSecond);
+}
+
+/*
+ *  BudgetSet - Changes the budget, 0 for none, and lifts the limits the
+ *  old one had imposed; the new one imposes its own as it needs to.
+ */
+void BudgetSet(Budget *budget, double bytesPerSecond) {
+  budget->budget = bytesPerSecond > 0 ? bytesPerSecond : 0.0;
+  budget->cap = budget->levels - 1;
+  budget->stretch = 1.0;
+  budget->sinceChange = 0;
+  budget->sinceStrain = 0;
+}
+
+/*
+ *  BudgetUpdate - Feeds in the bytes sent for the last frame, elapsed
+ *  nanoseconds after the one before.  Returns nonzero when the level
+ *  cap or the frame period has changed.
+ */
+int BudgetUpdate(Budget *budget, long bytes, int64_t elapsed) {
+  Budget *b = budget;
+  double rate;
+
+  if (elapsed <= 0) {
+    return (0);
+  }
+
+  rate = bytes * 1e9 / elapsed;
+  b->average = BUDGET_ALPHA * rate + (1.0 - BUDGET_ALPHA) * b->average;
+  if (b->budget <= 0) {
+    return (0);
+  }
+  b->sinceChange++;
+
+  if (b->average < BUDGET_CLIMB * b->budget) {
+    b->sinceStrain++;
+  } else {
+    b->sinceStrain = 0;
+  }
+
+  if (b->sinceChange < BUDGET_SETTLE) {
+    return (0);
+  }
+
+  if (b->average > b->budget) {
+    if (b->cap > 0) {
+      b->cap--;
+    } else if (b->stretch < BUDGET_MAX_STRETCH) {
+      /*
+       *  The rate goes with the frame rate
+       */
+      b->stretch *= b->average / b->budget;
+      if (b->stretch > BUDGET_MAX_STRETCH) {
+        b->stretch = BUDGET_MAX_STRETCH;
+      }
+    } else {
+      return (0);
+    }
+  } else if (b->sinceStrain >= BUDGET_CLIMB_WAIT) {
+    if (b->stretch > 1.0) {
+      b->stretch /= 2;
+      if (b->stretch < 1.0) {
+        b->stretch = 1.0;
+      }
+    } else if (b->cap < b->levels - 1) {
+      b->cap++;
+    } else {
+      return (0);
+    }
+  } else {
+    return (0);
+  }
+
+  b->sinceChange = 0;
+  b->sinceStrain = 0;
+
+  return (1);
+}
+
+/*
+ *  BudgetLevel - The level to use when level is the one wanted.
+ */
+int BudgetLevel(const Budget *budget, int level) {
+  return (level < budget->cap ? level : budget->cap);
+}
+
+/*
+ *  BudgetPeriod - The frame period to use when period is the one wanted.
+ */
+int64_t BudgetPeriod(const Budget *budget, int64_t period) {
+  return ((int64_t)(period * budget->stretch));
+}
+
+double BudgetRate(const Budget *budget) { return (budget->average); }
@@ -0,0 +1,41 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <stdint.h>
+
+/*
+ *  Bandwidth budget.
+ *
+ *  Holds what is sent to the X servers under a number of bytes a
+ *  second, for clients on slow links.  The rate is averaged
+ *  (exponentially weighted) over frames; while it is over budget the
+ *  quality level is capped a step lower at a time, and once at the
+ *  cheapest level the frame period is stretched instead.  A rate well
+ *  under budget for long enough undoes those steps again, the period
+ *  first.  Like the governor, it waits for the average to settle after
+ *  every change.
+ */
+#define BUDGET_ALPHA 0.05       /*  Weight of the newest sample         */
+#define BUDGET_CLIMB 0.5        /*  Climb when rate < this * budget     */
+#define BUDGET_SETTLE 60        /*  Frames to wait after any change     */
+#define BUDGET_CLIMB_WAIT 300   /*  Frames of headroom before a climb   */
+#define BUDGET_MAX_STRETCH 64.0 /*  Longest period, times the usual one */
+
+typedef struct {
+  double budget;   /*  Bytes a second, 0 = no limit  */
+  int levels;
+  int cap;         /*  Highest level allowed         */
+  double stretch;  /*  Frame period multiplier, >= 1 */
+  double average;  /*  Bytes a second                */
+  int sinceChange; /*  Frames since cap or stretch   */
+  int sinceStrain; /*  Frames with headroom          */
+} Budget;
+
+void BudgetInit(Budget *budget, int nLevels, double bytesPerSecond);
+void BudgetSet(Budget *budget, double bytesPerSecond);
+int BudgetUpdate(Budget *budget, long bytes, int64_t elapsed);
+int BudgetLevel(const Budget *budget, int level);
+int64_t BudgetPeriod(const Budget *budget, int64_t period);
+double BudgetRate(const Budget *budget);
+
+#endif
@@ -0,0 +1,530 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "catrender.h"
+#include "colorize.h"
+
+/*
+ *  Cat bitmap includes
+ */
+#include "graphics/bitmaps.h"
+
+#define TWOPI (2.0 * M_PI) /*  2.0 * M_PI  */
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+int Round(double x) { return (x >= 0.0 ? (int)(x + 0.5) : (int)(x - 0.5)); }
+
+/*
+ *  CatScaled - A size of n natural pixels at scale, never less than one.
+ */
+int CatScaled(int n, double scale) { return (max(Round(n * scale), 1)); }
+
+/*
+ *  CatDefaultColors - The colors the resources default to (black on
+ *  white), as 0xAARRGGBB, for rendering without a server to ask.
+ */
+void CatDefaultColors(CatColors *colors) {
+  colors->background = 0xffffffff;
+  colors->catColor = 0xff000000;
+  colors->detailColor = 0xffffffff;
+  colors->tieColor = 0xffffffff;
+  colors->handColor = 0xff000000;
+  colors->highlightColor = 0xff000000;
+}
+
+/*
+ *  CatSetLayout - Lays the cat out at scale with its top left corner at
+ *  x, y.
+ */
+void CatSetLayout(CatLayout *layout, double scale, int x, int y) {
+  layout->scale = scale;
+  layout->x = x;
+  layout->y = y;
+  layout->width = CatScaled(DEF_CAT_WIDTH, scale);
+  layout->height = CatScaled(DEF_CAT_HEIGHT, scale);
+  layout->tailY = Round((DEF_CAT_BOTTOM + 1) * scale);
+  layout->tailHeight = CatScaled(TAIL_HEIGHT, scale);
+  layout->eyesX = Round(DEF_EYES_X * scale);
+  layout->eyesY = Round(DEF_EYES_Y * scale);
+  layout->eyesWidth = CatScaled(eyes_width, scale);
+  layout->eyesHeight = CatScaled(eyes_height, scale);
+}
+
+/*
+ *  CatSetHands - Sizes the hands for a clock face of the given size.
+ */
+void CatSetHands(CatHands *hands, int width, int height, int padding) {
+  hands->radius = Round((min(width, height) - (2 * padding)) / 3.45);
+
+  hands->secondHandLength = ((SECOND_HAND_FRACT * hands->radius) / 100);
+  hands->minuteHandLength = ((MINUTE_HAND_FRACT * hands->radius) / 100);
+  hands->hourHandLength = ((HOUR_HAND_FRACT * hands->radius) / 100);
+
+  hands->handWidth = ((HAND_WIDTH_FRACT * hands->radius) / 100) * 2;
+  hands->secondHandWidth = ((SECOND_WIDTH_FRACT * hands->radius) / 100);
+
+  hands->centerX = width / 2;
+  hands->centerY = height / 2;
+}
+
+/*
+ *  CatHandPoints - Computes the outline of a hand.
+ *
+ *  length is the maximum length of the hand.
+ *  width is the half-width of the hand.
+ *  fractionOfACircle is a fraction between 0 and 1 (inclusive) indicating
+ *  how far around the circle (clockwise) from high noon.
+ *
+ *  VERTICES_IN_HANDS + 2 points are stored, pairwise, as DrawHand has
+ *  always laid them out in the segment buffer.
+ */
+void CatHandPoints(const CatHands *hands, int length, int width,
+                   double fractionOfACircle, XPoint *pts) {
+  double angle, cosAngle, sinAngle;
+  double ws, wc;
+  int x, y, x1, y1, x2, y2;
+
+  /*
+   *  A full circle is 2 PI radians.
+   *  Angles are measured from 12 o'clock, clockwise increasing.
+   *  Since in X, +x is to the right and +y is downward:
+   *
+   *    x = x0 + r * sin(theta)
+   *    y = y0 - r * cos(theta)
+   *
+   */
+  angle = TWOPI * fractionOfACircle;
+  cosAngle = cos(angle);
+  sinAngle = sin(angle);
+
+  /*
+   * Order of points when drawing the hand.
+   *
+   *        1,4
+   *        / \
+   *       /   \
+   *      /     \
+   *    2 ------- 3
+   */
+  wc = width * cosAngle;
+  ws = width * sinAngle;
+  x = hands->centerX + Round(length * sinAngle);
+  y = hands->centerY - Round(length * cosAngle);
+  x1 = hands->centerX - Round(ws + wc);
+  y1 = hands->centerY + Round(wc - ws);
+  x2 = hands->centerX - Round(ws - wc);
+  y2 = hands->centerY + Round(wc + ws);
+
+  pts[0].x = x; /* 1 ---- 2 */
+  pts[0].y = y;
+  pts[1].x = x1;
+  pts[1].y = y1;
+  pts[2].x = x1; /* 2 ----- 3 */
+  pts[2].y = y1;
+  pts[3].x = x2;
+  pts[3].y = y2;
+  pts[4].x = x2; /* 3 ----- 1(4) */
+  pts[4].y = y2;
+  pts[5].x = x;
+  pts[5].y = y;
+}
+
+/*
+ *  CatSecondPoints - Computes the second hand, a diamond out beyond the
+ *  tip of the minute hand, closed so its SECOND_HAND_PTS points can be
+ *  both filled and outlined.
+ */
+void CatSecondPoints(const CatHands *hands, double fractionOfACircle,
+                     XPoint *pts) {
+  int length = hands->secondHandLength - 2;
+  int offset = hands->minuteHandLength + 2;
+  int width = hands->secondHandWidth;
+  double angle, cosAngle, sinAngle;
+  double ms, mc, ws, wc;
+  int mid;
+
+  angle = TWOPI * fractionOfACircle;
+  cosAngle = cos(angle);
+  sinAngle = sin(angle);
+
+  /*
+   * Order of points when drawing the hand.
+   *
+   *        1,5
+   *        / \
+   *       /   \
+   *      /     \
+   *    2<       >4
+   *      \     /
+   *       \   /
+   *        \ /
+   *    -    3
+   *    |
+   *    |
+   *   offset
+   *    |
+   *    |
+   *    -     + center
+   */
+  mid = (length + offset) / 2;
+  mc = mid * cosAngle;
+  ms = mid * sinAngle;
+  wc = width * cosAngle;
+  ws = width * sinAngle;
+
+  pts[0].x = hands->centerX + Round(length * sinAngle);
+  pts[0].y = hands->centerY - Round(length * cosAngle);
+  pts[1].x = hands->centerX + Round(ms - wc);
+  pts[1].y = hands->centerY - Round(mc + ws);
+  pts[2].x = hands->centerX + Round(offset * sinAngle);
+  pts[2].y = hands->centerY - Round(offset * cosAngle);
+  pts[3].x = hands->centerX + Round(ms + wc);
+  pts[3].y = hands->centerY - Round(mc - ws);
+  pts[4] = pts[0];
+}
+
+/*
+ *  CatSecondFraction - How far round a secondHand style second hand is
+ *  at tm: on the second, or when it sweeps, nsec on from it.
+ */
+double CatSecondFraction(const struct tm *tm, long nsec, int secondHand) {
+  double second = tm->tm_sec;
+
+  if (secondHand == SECONDS_SWEEP) {
+    second += nsec / 1e9;
+  }
+
+  return (second / 60.0);
+}
+
+/*
+ *  CatPendulumFrame - Which of nTails tails & eyes go with phase
+ *  nanoseconds into the swing.
+ */
+int CatPendulumFrame(int64_t phase, int nTails) {
+  phase %= SWING_PERIOD;
+  if (phase < 0) {
+    phase += SWING_PERIOD;
+  }
+  if (phase > SWING_PERIOD / 2) {
+    phase = SWING_PERIOD - phase;
+  }
+
+  return (Round((double)phase * nTails / (SWING_PERIOD / 2)));
+}
+
+/*
+ *  CatPointsBox - The smallest rectangle holding every pixel a filled
+ *  and outlined polygon through the n pts can touch.
+ */
+void CatPointsBox(const XPoint *pts, int n, XRectangle *box) {
+  int x0 = pts[0].x, y0 = pts[0].y, x1 = pts[0].x, y1 = pts[0].y;
+  int i;
+
+  for (i = 1; i < n; i++) {
+    x0 = min(x0, pts[i].x);
+    y0 = min(y0, pts[i].y);
+    x1 = max(x1, pts[i].x);
+    y1 = max(y1, pts[i].y);
+  }
+
+  box->x = x0;
+  box->y = y0;
+  box->width = x1 - x0 + 1;
+  box->height = y1 - y0 + 1;
+}
+
+/*
+ *  CatTailPoints - Computes the tail polyline at pendulum time t,
+ *  in the coordinates of a tail pixmap scale times natural size.
+ */
+void CatTailPoints(double t, double scale, XPoint *pts) {
+  double sinTheta, cosTheta; /*  Pendulum parameters */
+  double A = 0.4;
+  double omega = 1.0;
+  double phi = 3 * M_PI_2;
+  double angle;
+
+  static XPoint tailOffset = {74, -15};
+
+  static XPoint tail[N_TAIL_PTS] = {
+      /*  "Center" tail definition */
+      {0, 0}, {0, 76}, {3, 82}, {10, 84}, {18, 82}, {21, 76}, {21, 70},
+  };
+
+  XPoint offCenterTail[N_TAIL_PTS]; /* off center tail    */
+  int i;
+
+  /*
+   *  Create an "off-center" tail to deal with the fact that
+   *  the tail has a hook to it.  A real pendulum so shaped would
+   *  hang a bit to the left (as you look at the cat).  It is
+   *  redone on every call rather than kept, so that frames can be
+   *  rendered on several threads at once.
+   */
+  angle = -0.08;
+  sinTheta = sin(angle);
+  cosTheta = cos(angle);
+
+  for (i = 0; i < N_TAIL_PTS; i++) {
+    offCenterTail[i].x = (int)((double)(tail[i].x) * cosTheta +
+                               (double)(tail[i].y) * sinTheta);
+    offCenterTail[i].y = (int)((double)(-tail[i].x) * sinTheta +
+                               (double)(tail[i].y) * cosTheta);
+  }
+
+  /*
+   *  Compute pendulum function.
+   */
+  angle = A * sin(omega * t + phi);
+  sinTheta = sin(angle);
+  cosTheta = cos(angle);
+
+  /*
+   *  Rotate the center tail about its origin by "angle" degrees.
+   */
+  for (i = 0; i < N_TAIL_PTS; i++) {
+    pts[i].x = (int)(scale * ((double)(offCenterTail[i].x) * cosTheta +
+                              (double)(offCenterTail[i].y) * sinTheta));
+    pts[i].y = (int)(scale * ((double)(-offCenterTail[i].x) * sinTheta +
+                              (double)(offCenterTail[i].y) * cosTheta));
+
+    pts[i].x += Round(tailOffset.x * scale);
+    pts[i].y += Round(tailOffset.y * scale);
+  }
+}
+
+/*
+ *  CatEyePoints - Computes the outline of the left eye at pendulum
+ *  time t, in the coordinates of an eye pixmap scale times natural
+ *  size.  The right eye is the same outline moved EYE_SPACING (scaled)
+ *  pixels over.  Returns the point count.
+ */
+int CatEyePoints(double t, double scale, XPoint *pts) {
+  double A = 0.7;
+  double omega = 1.0;
+  double phi = 3 * M_PI_2;
+  double angle;
+
+  double u, w;      /*  Sphere parameters    */
+  float r;          /*  Radius               */
+  float x0, y0, z0; /*  Center of sphere     */
+
+  int i;
+
+  typedef struct {
+    double x, y, z;
+  } Point3D;
+
+  /*
+   *  Compute pendulum function.
+   */
+  w = M_PI / 2.0;
+
+  angle = A * sin(omega * t + phi) + w;
+
+  x0 = 0.0;
+  y0 = 0.0;
+  z0 = 2.0;
+  r = 1.0;
+
+  for (i = 0, u = -M_PI / 2.0; u < M_PI / 2.0; i++, u += 0.25) {
+    Point3D pt;
+
+    pt.x = x0 + r * cos(u) * cos(angle + M_PI / 7.0);
+    pt.z = z0 + r * cos(u) * sin(angle + M_PI / 7.0);
+    pt.y = y0 + r * sin(u);
+
+    pts[i].x =
+        (int)((((pt.z == 0.0 ? pt.x : pt.x / pt.z) * 23.0) + 12.0) * scale);
+    pts[i].y =
+        (int)((((pt.z == 0.0 ? pt.y : pt.y / pt.z) * 23.0) + 11.0) * scale);
+  }
+
+  for (u = M_PI / 2.0; u > -M_PI / 2.0; i++, u -= 0.25) {
+    Point3D pt;
+
+    pt.x = x0 + r * cos(u) * cos(angle - M_PI / 7.0);
+    pt.z = z0 + r * cos(u) * sin(angle - M_PI / 7.0);
+    pt.y = y0 + r * sin(u);
+
+    pts[i].x =
+        (int)((((pt.z == 0.0 ? pt.x : pt.x / pt.z) * 23.0) + 12.0) * scale);
+    pts[i].y =
+        (int)((((pt.z == 0.0 ? pt.y : pt.y / pt.z) * 23.0) + 11.0) * scale);
+  }
+
+  return (i);
+}
+
+/*
+ *  CatScaledBitmap - XBM data as a bitmap scale times its size.  The
+ *  artwork is blown up pixel for pixel; only what is drawn on top of it
+ *  is rendered at the new size.
+ */
+RasterBitmap *CatScaledBitmap(const char *bits, int width, int height,
+                              double scale) {
+  RasterBitmap *bitmap, *scaled;
+
+  bitmap = RasterBitmapFromData(bits, width, height);
+  if (scale == 1.0) {
+    return (bitmap);
+  }
+
+  scaled = RasterBitmapScale(bitmap, CatScaled(width, scale),
+                             CatScaled(height, scale));
+  RasterBitmapDestroy(bitmap);
+
+  return (scaled);
+}
+
+/*
+ *  CatRenderTail - Software equivalent of drawing the tail into a copy
+ *  of tail_bits with a 15 pixel, round capped, round joined line, all
+ *  scale times natural size.  Each thread keeps its own scaled base.
+ */
+RasterBitmap *CatRenderTail(double t, double scale) {
+  static __thread RasterBitmap *tailBase = (RasterBitmap *)NULL;
+  static __thread double baseScale = 0.0;
+  RasterBitmap *tailBitmap;
+  XPoint newTail[N_TAIL_PTS]; /*  Tail at time "t"  */
+
+  if (tailBase == NULL || baseScale != scale) {
+    RasterBitmapDestroy(tailBase);
+    tailBase = CatScaledBitmap(tail_bits, tail_width, tail_height, scale);
+    baseScale = scale;
+  }
+  tailBitmap = RasterBitmapCreate(tailBase->width, tailBase->height);
+  RasterBitmapCopy(tailBitmap, tailBase);
+
+  CatTailPoints(t, scale, newTail);
+  RasterBitmapWideLines(tailBitmap, newTail, N_TAIL_PTS,
+                        CatScaled(15, scale));
+
+  return (tailBitmap);
+}
+
+/*
+ *  CatRenderEyes - Software equivalent of filling both eye outlines
+ *  into a copy of eyes_bits, all scale times natural size.
+ */
+RasterBitmap *CatRenderEyes(double t, double scale) {
+  static __thread RasterBitmap *eyeBase = (RasterBitmap *)NULL;
+  static __thread double baseScale = 0.0;
+  RasterBitmap *eyeBitmap;
+  XPoint pts[MAX_EYE_PTS];
+  int spacing = Round(EYE_SPACING * scale);
+  int i, j;
+
+  if (eyeBase == NULL || baseScale != scale) {
+    RasterBitmapDestroy(eyeBase);
+    eyeBase = CatScaledBitmap(eyes_bits, eyes_width, eyes_height, scale);
+    baseScale = scale;
+  }
+  eyeBitmap = RasterBitmapCreate(eyeBase->width, eyeBase->height);
+  RasterBitmapCopy(eyeBitmap, eyeBase);
+
+  i = CatEyePoints(t, scale, pts);
+  RasterBitmapFillPolygon(eyeBitmap, pts, i);
+
+  for (j = 0; j < i; j++) {
+    pts[j].x += spacing;
+  }
+  RasterBitmapFillPolygon(eyeBitmap, pts, i);
+
+  return (eyeBitmap);
+}
+
+/*
+ *  CatRenderBody - Builds the body tile InitializeCat used to paint on
+ *  the server (catback opaque-stippled, then catwhite and cattie
+ *  stippled on top), in one colorizing pass.
+ */
+RasterImage *CatRenderBody(const CatColors *colors, double scale) {
+  RasterImage *body;
+  RasterBitmap *back, *white, *tie;
+  ColorizeColors bodyColors;
+
+  body = RasterImageCreate(CatScaled(DEF_CAT_WIDTH, scale),
+                           CatScaled(DEF_CAT_HEIGHT, scale));
+
+  back = CatScaledBitmap(catback_bits, catback_width, catback_height, scale);
+  white =
+      CatScaledBitmap(catwhite_bits, catwhite_width, catwhite_height, scale);
+  tie = CatScaledBitmap(cattie_bits, cattie_width, cattie_height, scale);
+
+  bodyColors.background = colors->background;
+  bodyColors.catColor = colors->catColor;
+  bodyColors.detailColor = colors->detailColor;
+  bodyColors.tieColor = colors->tieColor;
+  ColorizeBody(body, back, white, tie, &bodyColors);
+
+  RasterBitmapDestroy(back);
+  RasterBitmapDestroy(white);
+  RasterBitmapDestroy(tie);
+
+  return (body);
+}
+
+static void RenderHand(RasterImage *dst, const CatColors *colors,
+                       const CatHands *hands, int length,
+                       double fractionOfACircle) {
+  XPoint pts[VERTICES_IN_HANDS + 2];
+
+  CatHandPoints(hands, length, hands->handWidth, fractionOfACircle, pts);
+
+  if (colors->handColor != colors->background) {
+    RasterFillPolygon(dst, pts, VERTICES_IN_HANDS + 2, colors->handColor);
+  }
+  RasterDrawLines(dst, pts, VERTICES_IN_HANDS + 2, colors->highlightColor);
+}
+
+/*
+ *  CatRenderSecond - Draws the second hand, pts from CatSecondPoints,
+ *  over a frame CatRenderFrame composed.
+ */
+void CatRenderSecond(RasterImage *dst, const CatColors *colors,
+                     const XPoint *pts, const CatLayout *layout) {
+  XPoint bodyPts[SECOND_HAND_PTS];
+  int i;
+
+  for (i = 0; i < SECOND_HAND_PTS; i++) {
+    bodyPts[i].x = pts[i].x - layout->x;
+    bodyPts[i].y = pts[i].y - layout->y;
+  }
+
+  if (colors->handColor != colors->background) {
+    RasterFillPolygon(dst, bodyPts, SECOND_HAND_PTS, colors->handColor);
+  }
+  RasterDrawLines(dst, bodyPts, SECOND_HAND_PTS, colors->highlightColor);
+}
+
+/*
+ *  CatRenderFrame - Composes one complete frame: body tile, tail, eyes
+ *  and the minute and hour hands for tm (already on a 12 hour clock).
+ *  dst holds just the body, at the layout's scale; the hands are in
+ *  window coordinates.
+ */
+void CatRenderFrame(RasterImage *dst, const RasterImage *body,
+                    const RasterBitmap *tail, const RasterBitmap *eyes,
+                    const CatColors *colors, const CatHands *hands,
+                    const CatLayout *layout, const struct tm *tm) {
+  CatHands bodyHands = *hands;
+
+  bodyHands.centerX -= layout->x;
+  bodyHands.centerY -= layout->y;
+
+  RasterCopyArea(dst, body, 0, 0, layout->width, layout->height, 0, 0);
+
+  RenderHand(dst, colors, &bodyHands, hands->minuteHandLength,
+             ((double)tm->tm_min) / 60.0);
+  RenderHand(dst, colors, &bodyHands, hands->hourHandLength,
+             ((((double)tm->tm_hour) + (((double)tm->tm_min) / 60.0)) / 12.0));
+
+  RasterCopyPlane(dst, tail, 0, 0, tail->width, tail->height, 0,
+                  layout->tailY, colors->catColor, colors->background);
+  RasterCopyPlane(dst, eyes, 0, 0, eyes->width, eyes->height, layout->eyesX,
+                  layout->eyesY, colors->catColor, colors->detailColor);
+}
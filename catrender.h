@@ -0,0 +1,125 @@
+#ifndef CATRENDER_H
+#define CATRENDER_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <X11/Xlib.h>
+
+#include "raster.h"
+
+/*
+ *  Default cat dimension stuff -- don't change sizes!!!!
+ */
+#define DEF_N_TAILS 40     /*  Default resolution        */
+#define TAIL_HEIGHT 89     /*  Tail pixmap height        */
+#define DEF_CAT_WIDTH 150  /*  Cat body pixmap width     */
+#define DEF_CAT_HEIGHT 300 /*  Cat body pixmap height    */
+#define DEF_CAT_BOTTOM 210 /*  Distance to cat's butt    */
+#define DEF_EYES_X 49      /*  Eye pixmap origin         */
+#define DEF_EYES_Y 30
+#define EYE_SPACING 31 /*  Left eye to right eye     */
+
+#define N_TAIL_PTS 7    /*  Tail polyline             */
+#define MAX_EYE_PTS 100 /*  Eye outline               */
+
+/*
+ *  Clock hand stuff
+ */
+#define VERTICES_IN_HANDS 4  /*  Hands are triangles      */
+#define SECOND_HAND_FRACT 90 /*  Percentages of radius    */
+#define MINUTE_HAND_FRACT 70
+#define HOUR_HAND_FRACT 40
+#define HAND_WIDTH_FRACT 7
+#define SECOND_WIDTH_FRACT 5
+#define SECOND_HAND_PTS 5 /*  Diamond, closed          */
+
+/*
+ *  Second hand: none, one step a second, or moved on every frame
+ */
+#define SECONDS_NONE 0
+#define SECONDS_TICK 1
+#define SECONDS_SWEEP 2
+
+/*
+ *  The pendulum swings across and back once every SWING_PERIOD
+ *  nanoseconds, whatever the tail resolution or frame rate.
+ */
+#define SWING_PERIOD ((int64_t)2000000000)
+
+/*
+ *  Colors for the software renderer, in whatever pixel format the
+ *  destination image uses.
+ */
+typedef struct {
+  uint32_t background;
+  uint32_t catColor;
+  uint32_t detailColor;
+  uint32_t tieColor;
+  uint32_t handColor;
+  uint32_t highlightColor;
+} CatColors;
+
+/*
+ *  Where the parts of the cat go when it is drawn scale times its
+ *  natural size with its top left corner at x, y in the window.  The
+ *  tail and eye positions are relative to that corner; the tail frame
+ *  is as wide as the body.
+ */
+typedef struct {
+  double scale;
+  int x; /*  Body origin in the window   */
+  int y;
+  int width; /*  Body size                   */
+  int height;
+  int tailY; /*  Just below the cat's butt   */
+  int tailHeight;
+  int eyesX;
+  int eyesY;
+  int eyesWidth;
+  int eyesHeight;
+} CatLayout;
+
+typedef struct {
+  int centerX; /*  Window coord origin of      */
+  int centerY; /*  clock hands.                */
+
+  int radius; /*  Radius of clock face        */
+
+  int secondHandLength; /*  Current lengths and widths  */
+  int minuteHandLength;
+  int hourHandLength;
+  int handWidth;
+  int secondHandWidth;
+} CatHands;
+
+int Round(double x);
+int CatScaled(int n, double scale);
+
+void CatDefaultColors(CatColors *colors);
+void CatSetLayout(CatLayout *layout, double scale, int x, int y);
+void CatSetHands(CatHands *hands, int width, int height, int padding);
+void CatHandPoints(const CatHands *hands, int length, int width,
+                   double fractionOfACircle, XPoint *pts);
+void CatSecondPoints(const CatHands *hands, double fractionOfACircle,
+                     XPoint *pts);
+double CatSecondFraction(const struct tm *tm, long nsec, int secondHand);
+int CatPendulumFrame(int64_t phase, int nTails);
+void CatPointsBox(const XPoint *pts, int n, XRectangle *box);
+
+void CatTailPoints(double t, double scale, XPoint *pts);
+int CatEyePoints(double t, double scale, XPoint *pts);
+
+RasterBitmap *CatScaledBitmap(const char *bits, int width, int height,
+                              double scale);
+RasterBitmap *CatRenderTail(double t, double scale);
+RasterBitmap *CatRenderEyes(double t, double scale);
+RasterImage *CatRenderBody(const CatColors *colors, double scale);
+void CatRenderFrame(RasterImage *dst, const RasterImage *body,
+                    const RasterBitmap *tail, const RasterBitmap *eyes,
+                    const CatColors *colors, const CatHands *hands,
+                    const CatLayout *layout, const struct tm *tm);
+void CatRenderSecond(RasterImage *dst, const CatColors *colors,
+                     const XPoint *pts, const CatLayout *layout);
+
+#endif
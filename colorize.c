@@ -0,0 +1,198 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "colorize.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define COLORIZE_X86
+#include <immintrin.h>
+#endif
+
+/*
+ *  A RowProc colors the pixels of one row from x on; the bitmap rows
+ *  start at pixel 0.
+ */
+typedef void (*RowProc)(uint32_t *dst, const unsigned char *back,
+                        const unsigned char *white, const unsigned char *tie,
+                        int x, int width, const ColorizeColors *colors);
+
+typedef struct {
+  const char *name;
+  RowProc row;
+  int (*supported)(void); /*  NULL if it runs anywhere  */
+} Kernel;
+
+static void RowScalar(uint32_t *dst, const unsigned char *back,
+                      const unsigned char *white, const unsigned char *tie,
+                      int x, int width, const ColorizeColors *colors) {
+  for (; x < width; x++) {
+    int byte = x >> 3;
+    int bit = 1 << (x & 7);
+
+    dst[x] = tie[byte] & bit     ? colors->tieColor
+             : white[byte] & bit ? colors->detailColor
+             : back[byte] & bit  ? colors->catColor
+                                 : colors->background;
+  }
+}
+
+#ifdef COLORIZE_X86
+
+/*
+ *  The vector versions turn one byte of a bitmap into a mask per pixel
+ *  by testing it against the lane's bit, then blend the colors through
+ *  the masks in painting order.  Whatever is left of a row after the
+ *  last whole byte goes to RowScalar.
+ */
+__attribute__((target("sse2"))) static inline __m128i
+Expand128(int byte, __m128i bits) {
+  return (_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(byte), bits), bits));
+}
+
+__attribute__((target("sse2"))) static inline __m128i
+Blend128(__m128i under, __m128i over, __m128i mask) {
+  return (
+      _mm_or_si128(_mm_and_si128(mask, over), _mm_andnot_si128(mask, under)));
+}
+
+__attribute__((target("sse2"))) static void
+RowSSE2(uint32_t *dst, const unsigned char *back, const unsigned char *white,
+        const unsigned char *tie, int x, int width,
+        const ColorizeColors *colors) {
+  const __m128i lo = _mm_setr_epi32(1, 2, 4, 8);
+  const __m128i hi = _mm_setr_epi32(16, 32, 64, 128);
+  const __m128i bg = _mm_set1_epi32((int)colors->background);
+  const __m128i cat = _mm_set1_epi32((int)colors->catColor);
+  const __m128i detail = _mm_set1_epi32((int)colors->detailColor);
+  const __m128i tieColor = _mm_set1_epi32((int)colors->tieColor);
+
+  for (; x + 8 <= width; x += 8) {
+    int i = x >> 3;
+    __m128i px0 = Blend128(bg, cat, Expand128(back[i], lo));
+    __m128i px1 = Blend128(bg, cat, Expand128(back[i], hi));
+
+    px0 = Blend128(px0, detail, Expand128(white[i], lo));
+    px1 = Blend128(px1, detail, Expand128(white[i], hi));
+    px0 = Blend128(px0, tieColor, Expand128(tie[i], lo));
+    px1 = Blend128(px1, tieColor, Expand128(tie[i], hi));
+
+    _mm_storeu_si128((__m128i *)(dst + x), px0);
+    _mm_storeu_si128((__m128i *)(dst + x + 4), px1);
+  }
+
+  RowScalar(dst, back, white, tie, x, width, colors);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+Expand256(int byte, __m256i bits) {
+  return (_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(byte), bits),
+                             bits));
+}
+
+__attribute__((target("avx2"))) static void
+RowAVX2(uint32_t *dst, const unsigned char *back, const unsigned char *white,
+        const unsigned char *tie, int x, int width,
+        const ColorizeColors *colors) {
+  const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const __m256i bg = _mm256_set1_epi32((int)colors->background);
+  const __m256i cat = _mm256_set1_epi32((int)colors->catColor);
+  const __m256i detail = _mm256_set1_epi32((int)colors->detailColor);
+  const __m256i tieColor = _mm256_set1_epi32((int)colors->tieColor);
+
+  for (; x + 8 <= width; x += 8) {
+    int i = x >> 3;
+    __m256i px = _mm256_blendv_epi8(bg, cat, Expand256(back[i], bits));
+
+    px = _mm256_blendv_epi8(px, detail, Expand256(white[i], bits));
+    px = _mm256_blendv_epi8(px, tieColor, Expand256(tie[i], bits));
+
+    _mm256_storeu_si256((__m256i *)(dst + x), px);
+  }
+
+  RowScalar(dst, back, white, tie, x, width, colors);
+}
+
+static int HaveSSE2(void) {
+  __builtin_cpu_init();
+  return (__builtin_cpu_supports("sse2"));
+}
+
+static int HaveAVX2(void) {
+  __builtin_cpu_init();
+  return (__builtin_cpu_supports("avx2"));
+}
+
+#endif
+
+/*
+ *  Best first
+ */
+static const Kernel kernels[] = {
+#ifdef COLORIZE_X86
+    {"avx2", RowAVX2, HaveAVX2},
+    {"sse2", RowSSE2, HaveSSE2},
+#endif
+    {"scalar", RowScalar, NULL},
+};
+
+#define N_KERNELS ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+static const Kernel *kernel = NULL; /*  In use; NULL until first needed  */
+static pthread_once_t kernelOnce = PTHREAD_ONCE_INIT;
+
+/*
+ *  PickKernel - Picks the best kernel, once, on whichever thread first
+ *  needs one, unless ColorizeUseKernel already picked.
+ */
+static void PickKernel(void) {
+  if (kernel == NULL) {
+    ColorizeUseKernel(NULL);
+  }
+}
+
+/*
+ *  ColorizeUseKernel - Switches to the kernel called name, or back to
+ *  the best one the CPU runs if name is NULL.  Returns 0, leaving the
+ *  kernel alone, if there is no such kernel or the CPU lacks it.  Not
+ *  to be called while another thread is colorizing.
+ */
+int ColorizeUseKernel(const char *name) {
+  int i;
+
+  for (i = 0; i < N_KERNELS; i++) {
+    if ((name == NULL || strcmp(name, kernels[i].name) == 0) &&
+        (kernels[i].supported == NULL || kernels[i].supported())) {
+      kernel = &kernels[i];
+      return (1);
+    }
+  }
+
+  return (0);
+}
+
+/*
+ *  ColorizeKernel - Name of the kernel ColorizeBody uses.
+ */
+const char *ColorizeKernel(void) {
+  pthread_once(&kernelOnce, PickKernel);
+
+  return (kernel->name);
+}
+
+/*
+ *  ColorizeBody - Fills dst with the body the three bitmaps make in
+ *  colors.  The bitmaps must be at least as large as dst.
+ */
+void ColorizeBody(RasterImage *dst, const RasterBitmap *back,
+                  const RasterBitmap *white, const RasterBitmap *tie,
+                  const ColorizeColors *colors) {
+  int y;
+
+  pthread_once(&kernelOnce, PickKernel);
+
+  for (y = 0; y < dst->height; y++) {
+    kernel->row(dst->pixels + y * dst->stride, back->bits + y * back->stride,
+                white->bits + y * white->stride, tie->bits + y * tie->stride,
+                0, dst->width, colors);
+  }
+}
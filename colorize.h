@@ -0,0 +1,35 @@
+#ifndef COLORIZE_H
+#define COLORIZE_H
+
+#include <stdint.h>
+
+#include "raster.h"
+
+/*
+ *  Body colorizer.
+ *
+ *  Decodes the three bitmaps the cat's body is made of (catback,
+ *  catwhite and cattie, in XBM layout and all the same size) and writes
+ *  the colored body in one pass: tie over detail over cat, background
+ *  where no bit is set.  That is what an opaque-stippled catback fill
+ *  followed by stippled catwhite and cattie fills leaves behind.
+ *
+ *  Eight pixels are expanded from each byte of the three bitmaps at
+ *  once with SSE2 or AVX2 where the CPU has them; which one is decided
+ *  at run time, with a plain C version for everything else.
+ */
+typedef struct {
+  uint32_t background;
+  uint32_t catColor;
+  uint32_t detailColor;
+  uint32_t tieColor;
+} ColorizeColors;
+
+void ColorizeBody(RasterImage *dst, const RasterBitmap *back,
+                  const RasterBitmap *white, const RasterBitmap *tie,
+                  const ColorizeColors *colors);
+
+const char *ColorizeKernel(void);
+int ColorizeUseKernel(const char *name);
+
+#endif
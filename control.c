@@ -0,0 +1,321 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <X11/Xlibint.h>
+
+#include "control.h"
+#include "sched.h"
+
+#define MAX_LINE 256 /*  Longer command lines are dropped  */
+
+/*
+ *  Upper bounds of the lateness buckets, seconds; the last bucket
+ *  takes everything later
+ */
+static const double lateBounds[N_LATE_BUCKETS - 1] = {
+    0.0001, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1};
+
+typedef struct {
+  int fd;
+  XtInputId id;
+  char line[MAX_LINE];
+  int length;
+} ControlClient;
+
+Metrics metrics;
+
+static XtAppContext controlApp;
+static ControlProc controlProc;
+static char *socketPath;
+
+/*
+ *  MetricsLateness - Counts a timer that fired late nanoseconds after
+ *  its deadline.
+ */
+void MetricsLateness(int64_t late) {
+  double seconds = late / 1e9;
+  int i;
+
+  for (i = 0; i < N_LATE_BUCKETS - 1 && seconds > lateBounds[i]; i++)
+    ;
+
+  metrics.late[i]++;
+  metrics.lateSum += seconds;
+  metrics.lateCount++;
+}
+
+static void CountFlush(Display *dpy, XExtCodes *codes, const char *data,
+                       long length) {
+  (void *)dpy;
+  (void *)codes;
+  (void *)data;
+
+  metrics.bytesFlushed += length;
+}
+
+/*
+ *  MetricsWatchDisplay - Counts every byte Xlib sends to dpy, whoever
+ *  flushes it, through a before-flush hook on a private extension slot.
+ */
+void MetricsWatchDisplay(Display *dpy) {
+  XExtCodes *codes = XAddExtension(dpy);
+
+  XESetBeforeFlush(dpy, codes->extension, CountFlush);
+}
+
+/*
+ *  MetricsMark - Marks where dpy's requests stand: the bytes are those
+ *  flushed to every server and those still in dpy's buffer, so counting
+ *  from the mark is only right while nothing else flushes meanwhile.
+ */
+void MetricsMark(Display *dpy, TrafficMark *mark) {
+  mark->requests = dpy->request;
+  mark->bytes = metrics.bytesFlushed + (dpy->bufptr - dpy->buffer);
+}
+
+/*
+ *  MetricsTraffic - Adds the requests and bytes sent to dpy since mark,
+ *  which MetricsWatchDisplay must be counting, to requests and bytes.
+ *  Returns the bytes.
+ */
+long MetricsTraffic(Display *dpy, const TrafficMark *mark, long *requests,
+                    long *bytes) {
+  TrafficMark now;
+
+  MetricsMark(dpy, &now);
+  *requests += (long)(now.requests - mark->requests);
+  *bytes += now.bytes - mark->bytes;
+
+  return (now.bytes - mark->bytes);
+}
+
+static void CloseClient(ControlClient *client) {
+  XtRemoveInput(client->id);
+  close(client->fd);
+  free(client);
+}
+
+/*
+ *  Reply - Sends a line to client.  Replies are small, so a client that
+ *  is not reading them is not waited for: it loses them.
+ */
+static void Reply(ControlClient *client, const char *format, ...) {
+  char line[MAX_LINE];
+  va_list args;
+  int length;
+
+  va_start(args, format);
+  length = vsnprintf(line, sizeof(line) - 1, format, args);
+  va_end(args);
+
+  length = length < (int)sizeof(line) - 1 ? length : (int)sizeof(line) - 2;
+  line[length++] = '\n';
+  send(client->fd, line, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+static void ReplyMetrics(ControlClient *client) {
+  long cumulative = 0;
+  int64_t period = SchedGetPeriod();
+  int i;
+
+  Reply(client, "# TYPE catclock_frames_drawn_total counter");
+  Reply(client, "catclock_frames_drawn_total %ld", metrics.framesDrawn);
+  Reply(client, "# TYPE catclock_frames_planned_total counter");
+  Reply(client, "catclock_frames_planned_total %ld", metrics.framesPlanned);
+  Reply(client, "# TYPE catclock_frames_skipped_total counter");
+  Reply(client, "catclock_frames_skipped_total %ld", metrics.framesSkipped);
+  Reply(client, "# TYPE catclock_hand_redraws_total counter");
+  Reply(client, "catclock_hand_redraws_total %ld", metrics.handRedraws);
+  Reply(client, "# TYPE catclock_expose_repaints_total counter");
+  Reply(client, "catclock_expose_repaints_total %ld", metrics.exposeRepaints);
+  Reply(client, "# TYPE catclock_bytes_flushed_total counter");
+  Reply(client, "catclock_bytes_flushed_total %ld", metrics.bytesFlushed);
+  Reply(client, "# TYPE catclock_frame_requests_total counter");
+  Reply(client, "catclock_frame_requests_total %ld", metrics.frameRequests);
+  Reply(client, "# TYPE catclock_frame_bytes_total counter");
+  Reply(client, "catclock_frame_bytes_total %ld", metrics.frameBytes);
+  Reply(client, "# TYPE catclock_tail_requests_total counter");
+  Reply(client, "catclock_tail_requests_total %ld", metrics.tailRequests);
+  Reply(client, "# TYPE catclock_tail_bytes_total counter");
+  Reply(client, "catclock_tail_bytes_total %ld", metrics.tailBytes);
+
+  Reply(client, "# TYPE catclock_timer_lateness_seconds histogram");
+  for (i = 0; i < N_LATE_BUCKETS; i++) {
+    cumulative += metrics.late[i];
+    if (i < N_LATE_BUCKETS - 1) {
+      Reply(client, "catclock_timer_lateness_seconds_bucket{le=\"%g\"} %ld",
+            lateBounds[i], cumulative);
+    } else {
+      Reply(client, "catclock_timer_lateness_seconds_bucket{le=\"+Inf\"} %ld",
+            cumulative);
+    }
+  }
+  Reply(client, "catclock_timer_lateness_seconds_sum %.6f", metrics.lateSum);
+  Reply(client, "catclock_timer_lateness_seconds_count %ld",
+        metrics.lateCount);
+
+  Reply(client, "# TYPE catclock_fps gauge");
+  Reply(client, "catclock_fps %.3f", period > 0 ? 1e9 / period : 0.0);
+  Reply(client, "# TYPE catclock_tails gauge");
+  Reply(client, "catclock_tails %d", metrics.nTails);
+  Reply(client, "# TYPE catclock_paused gauge");
+  Reply(client, "catclock_paused %d", metrics.paused);
+  Reply(client, "# TYPE catclock_bandwidth_bytes_per_second gauge");
+  Reply(client, "catclock_bandwidth_bytes_per_second %.0f", metrics.bandwidth);
+  Reply(client, "# TYPE catclock_bandwidth_budget_bytes_per_second gauge");
+  Reply(client, "catclock_bandwidth_budget_bytes_per_second %.0f",
+        metrics.budget);
+}
+
+/*
+ *  Command - Carries out one line from client and answers it.
+ */
+static void Command(ControlClient *client, char *line) {
+  char *command, *arg, *save;
+  const char *error;
+
+  command = strtok_r(line, " \t\r", &save);
+  if (command == NULL) {
+    return;
+  }
+  arg = strtok_r(NULL, " \t\r", &save);
+
+  if (strcmp(command, "metrics") == 0) {
+    ReplyMetrics(client);
+    error = NULL;
+  } else if (strcmp(command, "help") == 0) {
+    Reply(client, "metrics       counters, Prometheus text format");
+    Reply(client, "fps n         frames per second, 0 = one per tail");
+    Reply(client, "tails n       tail resolution");
+    Reply(client, "bandwidth n   bytes a second to keep under, 0 = no limit");
+    Reply(client, "pause         stop animating");
+    Reply(client, "resume        start again");
+    error = NULL;
+  } else {
+    error = (*controlProc)(command, arg);
+  }
+
+  if (error != NULL) {
+    Reply(client, "error: %s", error);
+  } else {
+    Reply(client, "ok");
+  }
+}
+
+static void ClientInput(XtPointer closure, int *fd, XtInputId *id) {
+  ControlClient *client = (ControlClient *)closure;
+  char buffer[MAX_LINE];
+  ssize_t n;
+  int i;
+
+  (void *)id;
+
+  n = read(*fd, buffer, sizeof(buffer));
+  if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return;
+  }
+  if (n <= 0) {
+    CloseClient(client);
+    return;
+  }
+
+  for (i = 0; i < n; i++) {
+    if (buffer[i] == '\n') {
+      client->line[client->length < MAX_LINE ? client->length : 0] = '\0';
+      if (client->length < MAX_LINE) {
+        Command(client, client->line);
+      }
+      client->length = 0;
+    } else if (client->length < MAX_LINE - 1) {
+      client->line[client->length++] = buffer[i];
+    } else {
+      client->length = MAX_LINE; /*  Too long; skip to its end  */
+    }
+  }
+}
+
+static void ListenInput(XtPointer closure, int *fd, XtInputId *id) {
+  ControlClient *client;
+  int clientFd;
+
+  (void *)closure;
+  (void *)id;
+
+  clientFd = accept(*fd, NULL, NULL);
+  if (clientFd < 0) {
+    return;
+  }
+  fcntl(clientFd, F_SETFL, O_NONBLOCK);
+  fcntl(clientFd, F_SETFD, FD_CLOEXEC);
+
+  client = (ControlClient *)calloc(1, sizeof(ControlClient));
+  client->fd = clientFd;
+  client->id = XtAppAddInput(controlApp, clientFd, (XtPointer)XtInputReadMask,
+                             ClientInput, client);
+}
+
+static void RemoveSocket(void) { unlink(socketPath); }
+
+/*
+ *  ControlStart - Listens on a socket at path, readable by this user
+ *  only.  A socket left behind there by an earlier run is replaced;
+ *  anything else at path is not.
+ */
+Bool ControlStart(XtAppContext app, const char *path, ControlProc proc) {
+  struct sockaddr_un address;
+  struct stat st;
+  mode_t mask;
+  int fd, bound;
+
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "xclock: control socket path too long: %s\n", path);
+    return (False);
+  }
+
+  if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    unlink(path);
+  }
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("xclock: control socket");
+    return (False);
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+
+  /*
+   *  The socket is made with no access for anyone else, rather than
+   *  opened up until a chmod gets to it
+   */
+  mask = umask(077);
+  bound = bind(fd, (struct sockaddr *)&address, sizeof(address));
+  umask(mask);
+
+  if (bound < 0 || listen(fd, 4) < 0) {
+    perror(path);
+    close(fd);
+    return (False);
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+  controlApp = app;
+  controlProc = proc;
+  socketPath = strdup(path);
+  atexit(RemoveSocket);
+
+  XtAppAddInput(app, fd, (XtPointer)XtInputReadMask, ListenInput, NULL);
+
+  return (True);
+}
@@ -0,0 +1,67 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdint.h>
+
+#include <X11/Intrinsic.h>
+
+/*
+ *  Control socket.
+ *
+ *  A Unix domain stream socket that takes one command per line and
+ *  answers each with some lines of text and then "ok" or "error: ...".
+ *  "metrics" reports the counters below in the Prometheus text format,
+ *  so a monitoring agent can scrape them; "help" lists the commands.
+ *  Everything else goes to the ControlProc the application passed,
+ *  which returns NULL when it has carried the command out and an error
+ *  message when not.
+ *
+ *  The counters are kept whether or not the socket is open.
+ */
+#define N_LATE_BUCKETS 10
+
+typedef struct {
+  long framesDrawn;    /*  DrawFrame calls            */
+  long framesPlanned;  /*  Of those, planned ahead    */
+  long framesSkipped;  /*  Deadlines passed undrawn   */
+  long handRedraws;    /*  Frames that redrew hands   */
+  long exposeRepaints; /*  Face repaints for exposes  */
+  long bytesFlushed;   /*  To every X server          */
+
+  long frameRequests; /*  Sent drawing frames        */
+  long frameBytes;
+  long tailRequests; /*  Of those, for tail and eyes  */
+  long tailBytes;
+
+  long late[N_LATE_BUCKETS]; /*  Timer lateness histogram   */
+  double lateSum;            /*  Seconds                    */
+  long lateCount;
+
+  int nTails; /*  Gauges, kept by the application  */
+  int paused;
+  double bandwidth; /*  Bytes a second, averaged   */
+  double budget;    /*  Its limit, 0 = none        */
+} Metrics;
+
+/*
+ *  Where a display's request stream stood at some point, so that what
+ *  is sent from there on can be counted
+ */
+typedef struct {
+  unsigned long requests;
+  long bytes;
+} TrafficMark;
+
+extern Metrics metrics;
+
+typedef const char *(*ControlProc)(const char *command, const char *arg);
+
+void MetricsLateness(int64_t late);
+void MetricsWatchDisplay(Display *dpy);
+void MetricsMark(Display *dpy, TrafficMark *mark);
+long MetricsTraffic(Display *dpy, const TrafficMark *mark, long *requests,
+                    long *bytes);
+
+Bool ControlStart(XtAppContext app, const char *path, ControlProc proc);
+
+#endif
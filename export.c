@@ -0,0 +1,546 @@
+#define _XOPEN_SOURCE 700 /*  strptime  */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "catrender.h"
+#include "export.h"
+#include "frames.h"
+#include "raster.h"
+#include "timing.h"
+
+#define SLOTS_PER_THREAD 4 /*  Frames each thread may get ahead  */
+#define MAX_DIGITS 32      /*  Widest frame number in a PNG name  */
+
+/*
+ *  An encoded frame, waiting to be written
+ */
+typedef struct {
+  unsigned char *data;
+  size_t length;
+  size_t capacity;
+  int ready;
+} ExportSlot;
+
+typedef struct {
+  const ExportOptions *options;
+  int y4m; /*  Else PNGs                        */
+
+  /*
+   *  PNG names: prefix, the frame number, suffix
+   */
+  char *prefix;
+  char *suffix;
+  int digits;  /*  Width of the number                */
+  int zeroPad; /*  Padded with zeros, else spaces     */
+
+  CatColors colors;
+  CatLayout layout;
+  CatHands hands;
+  RasterImage *body;
+  FrameSet *frames; /*  All rendered before any thread starts  */
+
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  long nFrames;
+  long next;    /*  Next frame to hand out             */
+  long written; /*  Frames written so far              */
+  int failed;
+  int nSlots;
+  ExportSlot *slots; /*  Frame i goes in slot i % nSlots  */
+} ExportJob;
+
+/*
+ *  Room - Makes room for length more bytes in slot.
+ */
+static unsigned char *Room(ExportSlot *slot, size_t length) {
+  if (slot->length + length > slot->capacity) {
+    slot->capacity = (slot->length + length) * 2;
+    slot->data = (unsigned char *)realloc(slot->data, slot->capacity);
+  }
+
+  return (slot->data + slot->length);
+}
+
+static void Append(ExportSlot *slot, const void *data, size_t length) {
+  memcpy(Room(slot, length), data, length);
+  slot->length += length;
+}
+
+static void AppendBE32(ExportSlot *slot, uint32_t n) {
+  unsigned char bytes[4];
+
+  bytes[0] = n >> 24;
+  bytes[1] = n >> 16;
+  bytes[2] = n >> 8;
+  bytes[3] = n;
+  Append(slot, bytes, 4);
+}
+
+/*
+ *  AppendChunk - A PNG chunk: length, type, data, CRC of type and data.
+ */
+static void AppendChunk(ExportSlot *slot, const char *type,
+                        const unsigned char *data, size_t length) {
+  uLong crc = crc32(0, (const Bytef *)type, 4);
+
+  if (length > 0) { /*  crc32 of NULL is the initial value  */
+    crc = crc32(crc, data, (uInt)length);
+  }
+  AppendBE32(slot, (uint32_t)length);
+  Append(slot, type, 4);
+  if (length > 0) {
+    Append(slot, data, length);
+  }
+  AppendBE32(slot, (uint32_t)crc);
+}
+
+/*
+ *  EncodePNG - image as an 8-bit RGB PNG, rows unfiltered.  Deflating
+ *  at the fastest level keeps the cat's flat colors small enough.
+ */
+static int EncodePNG(const RasterImage *image, ExportSlot *slot) {
+  static const unsigned char signature[8] = {0x89, 'P',  'N',  'G',
+                                             '\r', '\n', 0x1a, '\n'};
+  size_t rowBytes = 1 + 3 * (size_t)image->width;
+  size_t rawLength = rowBytes * image->height;
+  unsigned char *raw = (unsigned char *)malloc(rawLength);
+  uLongf packedLength = compressBound(rawLength);
+  unsigned char *packed = (unsigned char *)malloc(packedLength);
+  unsigned char header[13];
+  int x, y, status;
+
+  for (y = 0; y < image->height; y++) {
+    const uint32_t *row = image->pixels + y * image->stride;
+    unsigned char *out = raw + y * rowBytes;
+
+    *out++ = 0; /*  Filter: none  */
+    for (x = 0; x < image->width; x++) {
+      *out++ = (row[x] >> 16) & 0xff;
+      *out++ = (row[x] >> 8) & 0xff;
+      *out++ = row[x] & 0xff;
+    }
+  }
+  status = compress2(packed, &packedLength, raw, rawLength, Z_BEST_SPEED);
+
+  if (status == Z_OK) {
+    header[0] = image->width >> 24;
+    header[1] = image->width >> 16;
+    header[2] = image->width >> 8;
+    header[3] = image->width;
+    header[4] = image->height >> 24;
+    header[5] = image->height >> 16;
+    header[6] = image->height >> 8;
+    header[7] = image->height;
+    header[8] = 8;  /*  Bits per sample  */
+    header[9] = 2;  /*  RGB              */
+    header[10] = 0; /*  Deflate          */
+    header[11] = 0; /*  Adaptive filters */
+    header[12] = 0; /*  Not interlaced   */
+
+    Append(slot, signature, sizeof(signature));
+    AppendChunk(slot, "IHDR", header, sizeof(header));
+    AppendChunk(slot, "IDAT", packed, packedLength);
+    AppendChunk(slot, "IEND", NULL, 0);
+  }
+
+  free(raw);
+  free(packed);
+
+  return (status == Z_OK ? 0 : -1);
+}
+
+/*
+ *  EncodeY4M - image as one YUV4MPEG2 frame, full range BT.601 4:2:0,
+ *  each chroma sample the mean of the up to four pixels it covers.
+ */
+static int EncodeY4M(const RasterImage *image, ExportSlot *slot) {
+  int width = image->width, height = image->height;
+  int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+  unsigned char *luma, *cb, *cr;
+  int x, y, dx, dy;
+
+  Append(slot, "FRAME\n", 6);
+  luma = Room(slot, (size_t)width * height +
+                        2 * (size_t)chromaWidth * chromaHeight);
+  cb = luma + (size_t)width * height;
+  cr = cb + (size_t)chromaWidth * chromaHeight;
+  slot->length += (size_t)width * height +
+                  2 * (size_t)chromaWidth * chromaHeight;
+
+  for (y = 0; y < height; y++) {
+    const uint32_t *row = image->pixels + y * image->stride;
+
+    for (x = 0; x < width; x++) {
+      int r = (row[x] >> 16) & 0xff, g = (row[x] >> 8) & 0xff;
+      int b = row[x] & 0xff;
+
+      luma[y * width + x] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+    }
+  }
+
+  for (y = 0; y < chromaHeight; y++) {
+    for (x = 0; x < chromaWidth; x++) {
+      int r = 0, g = 0, b = 0, n = 0;
+
+      for (dy = 0; dy < 2 && 2 * y + dy < height; dy++) {
+        const uint32_t *row = image->pixels + (2 * y + dy) * image->stride;
+
+        for (dx = 0; dx < 2 && 2 * x + dx < width; dx++) {
+          r += (row[2 * x + dx] >> 16) & 0xff;
+          g += (row[2 * x + dx] >> 8) & 0xff;
+          b += row[2 * x + dx] & 0xff;
+          n++;
+        }
+      }
+      r /= n;
+      g /= n;
+      b /= n;
+      cb[y * chromaWidth + x] = (-43 * r - 85 * g + 128 * b + 32896) >> 8;
+      cr[y * chromaWidth + x] = (128 * r - 107 * g - 21 * b + 32896) >> 8;
+    }
+  }
+
+  return (0);
+}
+
+/*
+ *  RenderFrame - Composes frame i of job into image.
+ */
+static void RenderFrame(ExportJob *job, long i, RasterImage *image) {
+  const ExportOptions *options = job->options;
+  int64_t offset = (int64_t)i * 1000000000 / options->fps;
+  time_t when = options->start + (time_t)(offset / 1000000000);
+  XPoint second[SECOND_HAND_PTS];
+  struct tm tm;
+  int tail;
+
+  localtime_r(&when, &tm);
+  if (tm.tm_hour > 12) {
+    tm.tm_hour -= 12;
+  }
+
+  tail = CatPendulumFrame(offset, job->frames->nTails);
+  CatRenderFrame(image, job->body, FrameSetTail(job->frames, tail),
+                 FrameSetEyes(job->frames, tail), &job->colors, &job->hands,
+                 &job->layout, &tm);
+
+  if (options->secondHand != SECONDS_NONE) {
+    CatSecondPoints(&job->hands,
+                    CatSecondFraction(&tm, (long)(offset % 1000000000),
+                                      options->secondHand),
+                    second);
+    CatRenderSecond(image, &job->colors, second, &job->layout);
+  }
+}
+
+/*
+ *  Worker - Renders and encodes frames, as long as there are some and
+ *  their slots have been written out.
+ */
+static void *Worker(void *closure) {
+  ExportJob *job = (ExportJob *)closure;
+  RasterImage *image =
+      RasterImageCreate(job->layout.width, job->layout.height);
+  ExportSlot *slot;
+  long i;
+  int status;
+
+  for (;;) {
+    pthread_mutex_lock(&job->lock);
+    while (!job->failed && job->next < job->nFrames &&
+           job->next >= job->written + job->nSlots) {
+      pthread_cond_wait(&job->changed, &job->lock);
+    }
+    if (job->failed || job->next >= job->nFrames) {
+      pthread_mutex_unlock(&job->lock);
+      break;
+    }
+    i = job->next++;
+    pthread_mutex_unlock(&job->lock);
+
+    /*
+     *  The slot's last frame, i - nSlots, has been written
+     */
+    slot = &job->slots[i % job->nSlots];
+    slot->length = 0;
+    RenderFrame(job, i, image);
+    status = job->y4m ? EncodeY4M(image, slot) : EncodePNG(image, slot);
+
+    pthread_mutex_lock(&job->lock);
+    if (status != 0) {
+      job->failed = 1;
+    }
+    slot->ready = 1;
+    pthread_cond_broadcast(&job->changed);
+    pthread_mutex_unlock(&job->lock);
+  }
+
+  RasterImageDestroy(image);
+
+  return (NULL);
+}
+
+/*
+ *  WriteSlot - Writes frame i, to fp or its own PNG.
+ */
+static int WriteSlot(ExportJob *job, long i, FILE *fp) {
+  ExportSlot *slot = &job->slots[i % job->nSlots];
+  char name[4096];
+  int status;
+
+  if (job->y4m) {
+    return (fwrite(slot->data, 1, slot->length, fp) == slot->length ? 0
+                                                                     : -1);
+  }
+
+  snprintf(name, sizeof(name), job->zeroPad ? "%s%0*ld%s" : "%s%*ld%s",
+           job->prefix, job->digits, i, job->suffix);
+  fp = fopen(name, "wb");
+  if (fp == NULL) {
+    perror(name);
+    return (-1);
+  }
+  status = fwrite(slot->data, 1, slot->length, fp) == slot->length ? 0 : -1;
+  if (fclose(fp) != 0 || status != 0) {
+    perror(name);
+    return (-1);
+  }
+
+  return (0);
+}
+
+/*
+ *  ParsePattern - Splits a PNG path pattern around its one conversion,
+ *  %d with an optional 0 flag and width, into job's prefix and suffix;
+ *  %% stands for a %.  Returns 0 on success.  Nothing else is taken,
+ *  since the names are not made by handing path to printf.
+ */
+static int ParsePattern(ExportJob *job, const char *path) {
+  const char *p;
+  char *out;
+  int conversions = 0;
+
+  job->prefix = out = (char *)malloc(strlen(path) + 1);
+  job->suffix = (char *)malloc(strlen(path) + 1);
+  job->suffix[0] = '\0';
+
+  for (p = path; *p != '\0'; p++) {
+    if (*p != '%') {
+      *out++ = *p;
+    } else if (p[1] == '%') {
+      *out++ = '%';
+      p++;
+    } else {
+      if (conversions++ > 0) {
+        return (-1);
+      }
+      p++;
+      job->zeroPad = *p == '0';
+      for (job->digits = 0; *p >= '0' && *p <= '9'; p++) {
+        job->digits = job->digits * 10 + (*p - '0');
+        if (job->digits > MAX_DIGITS) {
+          return (-1);
+        }
+      }
+      if (*p != 'd') {
+        return (-1);
+      }
+      *out = '\0';
+      out = job->suffix;
+    }
+  }
+  *out = '\0';
+
+  return (conversions == 1 ? 0 : -1);
+}
+
+/*
+ *  ExportParseTime - Reads a local time, "YYYY-MM-DD HH:MM[:SS]" (or
+ *  with a T between), or "HH:MM[:SS]" today, or seconds since the
+ *  epoch as "@N".  Returns 0 on success.
+ */
+int ExportParseTime(const char *string, time_t *when) {
+  static const char *formats[] = {"%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S",
+                                  "%Y-%m-%d %H:%M",    "%Y-%m-%dT%H:%M",
+                                  "%H:%M:%S",          "%H:%M"};
+  struct tm tm;
+  time_t now = time(NULL);
+  const char *end;
+  char *number;
+  int i;
+
+  if (string[0] == '@') {
+    *when = (time_t)strtoll(string + 1, &number, 10);
+    return (*number == '\0' && number != string + 1 ? 0 : -1);
+  }
+
+  for (i = 0; i < (int)(sizeof(formats) / sizeof(formats[0])); i++) {
+    localtime_r(&now, &tm);
+    tm.tm_sec = 0;
+    end = strptime(string, formats[i], &tm);
+    if (end != NULL && *end == '\0') {
+      tm.tm_isdst = -1;
+      *when = mktime(&tm);
+      return (*when == (time_t)-1 ? -1 : 0);
+    }
+  }
+
+  return (-1);
+}
+
+/*
+ *  Export - Renders and writes the frames options ask for.  Returns
+ *  the exit status.
+ */
+int Export(const ExportOptions *options) {
+  ExportJob job;
+  pthread_t *threads;
+  int nThreads = options->threads;
+  size_t pathLength = strlen(options->path);
+  int64_t start = TimingNow();
+  FILE *fp = NULL;
+  long i;
+  int t, nStarted;
+
+  memset(&job, 0, sizeof(job));
+  job.options = options;
+  job.nFrames = (long)(options->duration * options->fps + 0.5);
+
+  if (options->fps < 1 || job.nFrames < 1) {
+    fprintf(stderr, "xclock: nothing to export\n");
+    return (1);
+  }
+  if (strcmp(options->path, "-") == 0 ||
+      (pathLength > 4 &&
+       strcmp(options->path + pathLength - 4, ".y4m") == 0)) {
+    job.y4m = 1;
+  } else if (ParsePattern(&job, options->path) != 0) {
+    fprintf(stderr, "xclock: export to -, a .y4m file, or a pattern for "
+                    "PNGs with one %%d (%%06d to pad) and %%%% for a %%, "
+                    "such as cat%%06d.png\n");
+    free(job.prefix);
+    free(job.suffix);
+    return (1);
+  }
+
+  if (nThreads < 0 || nThreads > EXPORT_MAX_THREADS) {
+    fprintf(stderr, "xclock: export threads must be from 1 to %d, or 0 for "
+                    "one per CPU\n",
+            EXPORT_MAX_THREADS);
+    free(job.prefix);
+    free(job.suffix);
+    return (1);
+  }
+  if (nThreads == 0) {
+    nThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    nThreads = nThreads < 1 ? 1 : nThreads;
+    nThreads = nThreads > EXPORT_MAX_THREADS ? EXPORT_MAX_THREADS : nThreads;
+  }
+
+  CatDefaultColors(&job.colors);
+  CatSetLayout(&job.layout, options->scale, 0, 0);
+  CatSetHands(&job.hands, job.layout.width, job.layout.height,
+              options->padding);
+
+  /*
+   *  The stream is opened before anything is rendered, so failing to
+   *  leaves nothing to clean up
+   */
+  if (job.y4m) {
+    fp = strcmp(options->path, "-") == 0 ? stdout
+                                          : fopen(options->path, "wb");
+    if (fp == NULL) {
+      perror(options->path);
+      return (1);
+    }
+    fprintf(fp, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XYSCSS=420JPEG\n",
+            job.layout.width, job.layout.height, options->fps);
+  }
+
+  job.body = CatRenderBody(&job.colors, options->scale);
+  job.frames = FrameSetCreate(options->nTails, options->scale);
+  FrameSetRenderAll(job.frames);
+
+  pthread_mutex_init(&job.lock, NULL);
+  pthread_cond_init(&job.changed, NULL);
+  job.nSlots = nThreads * SLOTS_PER_THREAD;
+  job.slots = (ExportSlot *)calloc(job.nSlots, sizeof(ExportSlot));
+  threads = (pthread_t *)malloc(nThreads * sizeof(pthread_t));
+  for (nStarted = 0; nStarted < nThreads; nStarted++) {
+    if (pthread_create(&threads[nStarted], NULL, Worker, &job) != 0) {
+      fprintf(stderr, "xclock: could not start export thread %d of %d\n",
+              nStarted + 1, nThreads);
+      pthread_mutex_lock(&job.lock);
+      job.failed = 1;
+      pthread_cond_broadcast(&job.changed);
+      pthread_mutex_unlock(&job.lock);
+      break;
+    }
+  }
+
+  /*
+   *  Write the frames out in order as they come in
+   */
+  for (i = 0; i < job.nFrames; i++) {
+    ExportSlot *slot = &job.slots[i % job.nSlots];
+    int status;
+
+    pthread_mutex_lock(&job.lock);
+    while (!slot->ready && !job.failed) {
+      pthread_cond_wait(&job.changed, &job.lock);
+    }
+    pthread_mutex_unlock(&job.lock);
+    if (!slot->ready) {
+      break;
+    }
+
+    status = WriteSlot(&job, i, fp);
+
+    pthread_mutex_lock(&job.lock);
+    slot->ready = 0;
+    if (status == 0) {
+      job.written++;
+    } else {
+      job.failed = 1;
+    }
+    pthread_cond_broadcast(&job.changed);
+    pthread_mutex_unlock(&job.lock);
+    if (status != 0) {
+      break;
+    }
+  }
+
+  for (t = 0; t < nStarted; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  if (fp != NULL && (fflush(fp) != 0 || ferror(fp))) {
+    perror(options->path);
+    job.failed = 1;
+  }
+  if (fp != NULL && fp != stdout) {
+    fclose(fp);
+  }
+
+  fprintf(stderr, "xclock: exported %ld frames with %d threads in %.3f s\n",
+          job.written, nStarted, (TimingNow() - start) / 1e9);
+
+  for (t = 0; t < job.nSlots; t++) {
+    free(job.slots[t].data);
+  }
+  free(job.slots);
+  free(threads);
+  pthread_mutex_destroy(&job.lock);
+  pthread_cond_destroy(&job.changed);
+  FrameSetDestroy(job.frames);
+  RasterImageDestroy(job.body);
+  free(job.prefix);
+  free(job.suffix);
+
+  return (job.failed ? 1 : 0);
+}
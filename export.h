@@ -0,0 +1,36 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <time.h>
+
+/*
+ *  Batch export.
+ *
+ *  Renders the clock as it would look from start on, for duration
+ *  seconds at fps frames a second, with the software renderer and no
+ *  display.  Frames are rendered and encoded by a pool of threads, a
+ *  bounded window of them ahead of the one being written, and written
+ *  in order: as one YUV4MPEG2 stream (path "-" for stdout, or ending in
+ *  ".y4m"), or as numbered PNGs (path a pattern such as
+ *  "cat%06d.png": one %d, optionally 0 padded to a width, for the
+ *  frame number, and %% for a %).  The pendulum starts at frame 0, so
+ *  the same arguments always give the same frames.
+ */
+#define EXPORT_MAX_THREADS 256 /*  Most threads an export starts  */
+
+typedef struct {
+  const char *path;
+  time_t start;    /*  Wall clock time of frame 0      */
+  double duration; /*  Seconds                         */
+  int fps;
+  int threads; /*  0 = one per CPU                 */
+  double scale;
+  int padding; /*  Between the hands and the face  */
+  int nTails;
+  int secondHand; /*  SECONDS_NONE, _TICK or _SWEEP   */
+} ExportOptions;
+
+int ExportParseTime(const char *string, time_t *when);
+int Export(const ExportOptions *options);
+
+#endif
@@ -0,0 +1,351 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "catframes.h"
+#include "catrender.h"
+#include "frames.h"
+
+/*
+ *  Cat bitmap includes
+ */
+#include "graphics/bitmaps.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+static XRectangle Union(const XRectangle *a, const XRectangle *b) {
+  XRectangle u;
+
+  u.x = min(a->x, b->x);
+  u.y = min(a->y, b->y);
+  u.width = max(a->x + a->width, b->x + b->width) - u.x;
+  u.height = max(a->y + a->height, b->y + b->height) - u.y;
+
+  return (u);
+}
+
+/*
+ *  FrameDeltaCompute - Finds the DELTA_TILE x DELTA_TILE tiles in which
+ *  a and b differ, joins dirty tiles into horizontal runs, and stacks
+ *  runs that line up on consecutive tile rows into one rectangle.
+ */
+void FrameDeltaCompute(FrameDelta *delta, const RasterBitmap *a,
+                       const RasterBitmap *b) {
+  int tilesX = (a->width + DELTA_TILE - 1) / DELTA_TILE;
+  int tilesY = (a->height + DELTA_TILE - 1) / DELTA_TILE;
+  XRectangle rects[MAX_DELTA_RECTS];
+  int end[MAX_DELTA_RECTS]; /*  Tile row below each rect  */
+  char *dirty;
+  int tx, ty, x, y, i, n = 0;
+
+  dirty = (char *)calloc(tilesX, 1);
+
+  for (ty = 0; ty < tilesY && n >= 0; ty++) {
+    /*
+     *  Which tiles in this row differ?  Tiles are byte aligned.
+     */
+    memset(dirty, 0, tilesX);
+    for (y = ty * DELTA_TILE; y < min((ty + 1) * DELTA_TILE, a->height); y++) {
+      const unsigned char *ra = a->bits + y * a->stride;
+      const unsigned char *rb = b->bits + y * b->stride;
+
+      for (x = 0; x < a->stride; x++) {
+        if (ra[x] != rb[x]) {
+          dirty[x * 8 / DELTA_TILE] = 1;
+        }
+      }
+    }
+
+    for (tx = 0; tx < tilesX && n >= 0; tx++) {
+      int start = tx;
+
+      if (!dirty[tx]) {
+        continue;
+      }
+      while (tx + 1 < tilesX && dirty[tx + 1]) {
+        tx++;
+      }
+
+      /*
+       *  Same span as a rectangle that reached the row above? Grow it.
+       */
+      for (i = 0; i < n; i++) {
+        if (end[i] == ty && rects[i].x == start * DELTA_TILE &&
+            rects[i].width == (tx + 1 - start) * DELTA_TILE) {
+          rects[i].height += DELTA_TILE;
+          end[i] = ty + 1;
+          break;
+        }
+      }
+      if (i < n) {
+        continue;
+      }
+
+      if (n == MAX_DELTA_RECTS) {
+        n = -1;
+        break;
+      }
+      rects[n].x = start * DELTA_TILE;
+      rects[n].y = ty * DELTA_TILE;
+      rects[n].width = (tx + 1 - start) * DELTA_TILE;
+      rects[n].height = DELTA_TILE;
+      end[n] = ty + 1;
+      n++;
+    }
+
+  }
+
+  free(dirty);
+
+  /*
+   *  Every rectangle costs a request, so fold the pair whose bounding
+   *  box wastes the fewest pixels together until few enough are left.
+   */
+  while (n > DELTA_RECTS) {
+    int best = 0, bestJ = 1;
+    long bestWaste = -1;
+    int j;
+
+    for (i = 0; i < n; i++) {
+      for (j = i + 1; j < n; j++) {
+        XRectangle u = Union(&rects[i], &rects[j]);
+        long waste = (long)u.width * u.height -
+                     (long)rects[i].width * rects[i].height -
+                     (long)rects[j].width * rects[j].height;
+
+        if (bestWaste < 0 || waste < bestWaste) {
+          best = i;
+          bestJ = j;
+          bestWaste = waste;
+        }
+      }
+    }
+    rects[best] = Union(&rects[best], &rects[bestJ]);
+    rects[bestJ] = rects[--n];
+  }
+
+  /*
+   *  Clip the last tile row and column to the bitmap
+   */
+  for (i = 0; i < n; i++) {
+    rects[i].width = min(rects[i].width, a->width - rects[i].x);
+    rects[i].height = min(rects[i].height, a->height - rects[i].y);
+  }
+
+  delta->count = n;
+  delta->rects = NULL;
+  if (n > 0) {
+    delta->rects = (XRectangle *)malloc(n * sizeof(XRectangle));
+    memcpy(delta->rects, rects, n * sizeof(XRectangle));
+  }
+}
+
+void FrameDeltaFree(FrameDelta *delta) {
+  free(delta->rects);
+  delta->rects = NULL;
+  delta->count = 0;
+}
+
+/*
+ *  FrameSetCreate - An empty set for the nTails + 1 tail and eye frames
+ *  of one half swing at scale, and the deltas between neighbours.
+ */
+FrameSet *FrameSetCreate(int nTails, double scale) {
+  FrameSet *frames;
+  int i;
+
+  frames = (FrameSet *)malloc(sizeof(FrameSet));
+  frames->nTails = nTails;
+  frames->scale = scale;
+  frames->refs = 0;
+  frames->lastUsed = 0;
+  frames->tails =
+      (RasterBitmap **)calloc(nTails + 1, sizeof(RasterBitmap *));
+  frames->eyes = (RasterBitmap **)calloc(nTails + 1, sizeof(RasterBitmap *));
+  frames->tailDelta = (FrameDelta *)calloc(nTails, sizeof(FrameDelta));
+  frames->eyeDelta = (FrameDelta *)calloc(nTails, sizeof(FrameDelta));
+  frames->deltaDone = (char *)calloc(nTails, 1);
+  frames->tailTable = frames->eyeTable = NULL;
+
+  for (i = 0; i < N_CAT_FRAME_TABLES && scale == 1.0; i++) {
+    if (catFrameTables[i].nTails == nTails) {
+      frames->tailTable = catFrameTables[i].tails;
+      frames->eyeTable = catFrameTables[i].eyes;
+    }
+  }
+
+  return (frames);
+}
+
+/*
+ *  FrameSetRender - Renders frame i unless that has been done already.
+ *  Returns whether there was anything to do.
+ */
+Bool FrameSetRender(FrameSet *frames, int i) {
+  if (frames->tails[i] != NULL) {
+    return (False);
+  }
+
+  if (frames->tailTable != NULL) {
+    frames->tails[i] = RasterBitmapFromData(
+        (const char *)frames->tailTable + i * TAIL_FRAME_BYTES, tail_width,
+        tail_height);
+    frames->eyes[i] = RasterBitmapFromData(
+        (const char *)frames->eyeTable + i * EYE_FRAME_BYTES, eyes_width,
+        eyes_height);
+  } else {
+    frames->tails[i] =
+        CatRenderTail(i * M_PI / frames->nTails, frames->scale);
+    frames->eyes[i] = CatRenderEyes(i * M_PI / frames->nTails, frames->scale);
+  }
+
+  return (True);
+}
+
+void FrameSetRenderAll(FrameSet *frames) {
+  int i;
+
+  for (i = 0; i <= frames->nTails; i++) {
+    FrameSetRender(frames, i);
+  }
+}
+
+const RasterBitmap *FrameSetTail(FrameSet *frames, int i) {
+  FrameSetRender(frames, i);
+
+  return (frames->tails[i]);
+}
+
+const RasterBitmap *FrameSetEyes(FrameSet *frames, int i) {
+  FrameSetRender(frames, i);
+
+  return (frames->eyes[i]);
+}
+
+/*
+ *  ComputeDeltas - Diffs frame i against frame i + 1, on first use.
+ */
+static void ComputeDeltas(FrameSet *frames, int i) {
+  if (frames->deltaDone[i]) {
+    return;
+  }
+
+  FrameSetRender(frames, i);
+  FrameSetRender(frames, i + 1);
+
+  FrameDeltaCompute(&frames->tailDelta[i], frames->tails[i],
+                    frames->tails[i + 1]);
+  FrameDeltaCompute(&frames->eyeDelta[i], frames->eyes[i],
+                    frames->eyes[i + 1]);
+  frames->deltaDone[i] = 1;
+}
+
+void FrameSetDestroy(FrameSet *frames) {
+  int i;
+
+  for (i = 0; i <= frames->nTails; i++) {
+    RasterBitmapDestroy(frames->tails[i]);
+    RasterBitmapDestroy(frames->eyes[i]);
+  }
+  for (i = 0; i < frames->nTails; i++) {
+    FrameDeltaFree(&frames->tailDelta[i]);
+    FrameDeltaFree(&frames->eyeDelta[i]);
+  }
+  free(frames->tails);
+  free(frames->eyes);
+  free(frames->tailDelta);
+  free(frames->eyeDelta);
+  free(frames->deltaDone);
+  free(frames);
+}
+
+/*
+ *  FrameSet*Delta - What to copy to go from frame from to frame to, or
+ *  NULL if the whole frame has to be copied.
+ */
+const FrameDelta *FrameSetTailDelta(FrameSet *frames, int from, int to) {
+  const FrameDelta *delta;
+
+  if (from < 0 || abs(from - to) != 1) {
+    return (NULL);
+  }
+  ComputeDeltas(frames, min(from, to));
+  delta = &frames->tailDelta[min(from, to)];
+
+  return (delta->count < 0 ? NULL : delta);
+}
+
+const FrameDelta *FrameSetEyeDelta(FrameSet *frames, int from, int to) {
+  const FrameDelta *delta;
+
+  if (from < 0 || abs(from - to) != 1) {
+    return (NULL);
+  }
+  ComputeDeltas(frames, min(from, to));
+  delta = &frames->eyeDelta[min(from, to)];
+
+  return (delta->count < 0 ? NULL : delta);
+}
+
+static FrameSet **frameCache = (FrameSet **)NULL;
+static int nFrameCache = 0;
+static unsigned long releases = 0; /*  Ages unused sets  */
+
+/*
+ *  FrameCacheGet - The set for nTails at scale, made if need be.  Each
+ *  get is paired with a FrameCacheRelease.
+ */
+FrameSet *FrameCacheGet(int nTails, double scale) {
+  FrameSet *frames;
+  int i;
+
+  for (i = 0; i < nFrameCache; i++) {
+    if (frameCache[i]->nTails == nTails && frameCache[i]->scale == scale) {
+      frameCache[i]->refs++;
+      return (frameCache[i]);
+    }
+  }
+
+  frames = FrameSetCreate(nTails, scale);
+  frames->refs = 1;
+
+  frameCache = (FrameSet **)realloc(frameCache,
+                                    (nFrameCache + 1) * sizeof(FrameSet *));
+  frameCache[nFrameCache++] = frames;
+
+  return (frames);
+}
+
+/*
+ *  FrameCacheRelease - Drops a use of frames, and the least recently
+ *  used sets no one is using beyond FRAME_CACHE_SIZE.
+ */
+void FrameCacheRelease(FrameSet *frames) {
+  int unused, oldest, i;
+
+  if (frames == NULL) {
+    return;
+  }
+  frames->refs--;
+  frames->lastUsed = ++releases;
+
+  for (;;) {
+    unused = 0;
+    oldest = -1;
+    for (i = 0; i < nFrameCache; i++) {
+      if (frameCache[i]->refs == 0) {
+        unused++;
+        if (oldest < 0 ||
+            frameCache[i]->lastUsed < frameCache[oldest]->lastUsed) {
+          oldest = i;
+        }
+      }
+    }
+    if (unused <= FRAME_CACHE_SIZE) {
+      break;
+    }
+    FrameSetDestroy(frameCache[oldest]);
+    frameCache[oldest] = frameCache[--nFrameCache];
+  }
+}
@@ -0,0 +1,70 @@
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include <X11/Xlib.h>
+
+#include "raster.h"
+
+/*
+ *  Client side copy of every tail and eye frame, plus, for each pair of
+ *  neighbouring frames, the rectangles that differ between them.  A
+ *  pendulum step only moves a thin band of pixels, so copying just those
+ *  rectangles is far cheaper than copying the whole frame.
+ */
+#define DELTA_TILE 8       /*  Delta granularity, pixels */
+#define DELTA_RECTS 8      /*  Rects kept per delta      */
+#define MAX_DELTA_RECTS 32 /*  Beyond this, copy it all  */
+
+typedef struct {
+  int count;          /*  -1 = too many, copy it all */
+  XRectangle *rects;
+} FrameDelta;
+
+/*
+ *  Frames and deltas are rendered the first time they are asked for,
+ *  so creating a set costs nothing; FrameSetRender lets idle time get
+ *  ahead of the pendulum.  Tail counts that catframes.h was generated
+ *  for are copied out of its tables instead of rendered, at natural
+ *  size.
+ */
+typedef struct {
+  int nTails;
+  double scale;          /*  Of the cat's natural size   */
+  RasterBitmap **tails;  /*  nTails + 1 of each, NULL until rendered  */
+  RasterBitmap **eyes;
+  FrameDelta *tailDelta; /*  [i] = frame i vs frame i+1  */
+  FrameDelta *eyeDelta;
+  char *deltaDone;       /*  [i] = deltas [i] computed   */
+  const unsigned char *tailTable; /*  Prerendered frames, if   */
+  const unsigned char *eyeTable;  /*  built for this nTails    */
+  int refs;                       /*  FrameCacheGet users      */
+  unsigned long lastUsed;         /*  When last released       */
+} FrameSet;
+
+/*
+ *  Every set in use is kept by the frame cache, along with up to
+ *  FRAME_CACHE_SIZE that no longer are, most recently released first.
+ *  A window resized back to an earlier size, or a governor going back
+ *  to an earlier level, finds its frames still rendered.
+ */
+#define FRAME_CACHE_SIZE 8
+
+FrameSet *FrameSetCreate(int nTails, double scale);
+void FrameSetDestroy(FrameSet *frames);
+
+Bool FrameSetRender(FrameSet *frames, int i);
+void FrameSetRenderAll(FrameSet *frames);
+const RasterBitmap *FrameSetTail(FrameSet *frames, int i);
+const RasterBitmap *FrameSetEyes(FrameSet *frames, int i);
+
+const FrameDelta *FrameSetTailDelta(FrameSet *frames, int from, int to);
+const FrameDelta *FrameSetEyeDelta(FrameSet *frames, int from, int to);
+
+FrameSet *FrameCacheGet(int nTails, double scale);
+void FrameCacheRelease(FrameSet *frames);
+
+void FrameDeltaCompute(FrameDelta *delta, const RasterBitmap *a,
+                       const RasterBitmap *b);
+void FrameDeltaFree(FrameDelta *delta);
+
+#endif
@@ -0,0 +1,59 @@
+#include "governor.h"
+
+void GovernorInit(Governor *governor, int nLevels, int level) {
+  governor->levels = nLevels;
+  governor->current = level;
+  governor->average = 0.0;
+  governor->sinceChange = 0;
+  governor->sinceStrain = 0;
+  governor->climbWait = GOVERNOR_CLIMB_WAIT;
+  governor->climbed = 0;
+}
+
+/*
+ *  GovernorUpdate - Feeds in the latency of the last frame, presented
+ *  period nanoseconds after the one before, and returns the level the
+ *  next frame should use.
+ */
+int GovernorUpdate(Governor *governor, int64_t latency, int64_t period) {
+  Governor *g = governor;
+
+  g->average = GOVERNOR_ALPHA * latency + (1.0 - GOVERNOR_ALPHA) * g->average;
+  g->sinceChange++;
+
+  if (g->average < GOVERNOR_CLIMB * period) {
+    g->sinceStrain++;
+  } else {
+    g->sinceStrain = 0;
+  }
+
+  if (g->sinceChange < GOVERNOR_SETTLE) {
+    return (g->current);
+  }
+
+  if (g->average > GOVERNOR_DEGRADE * period && g->current > 0) {
+    if (g->climbed && g->sinceChange < g->climbWait) {
+      g->climbWait *= 2;
+      if (g->climbWait > GOVERNOR_MAX_CLIMB_WAIT) {
+        g->climbWait = GOVERNOR_MAX_CLIMB_WAIT;
+      }
+    }
+    g->current--;
+    g->climbed = 0;
+    g->sinceChange = 0;
+    g->sinceStrain = 0;
+  } else if (g->sinceStrain >= g->climbWait && g->current < g->levels - 1) {
+    g->current++;
+    g->climbed = 1;
+    g->sinceChange = 0;
+    g->sinceStrain = 0;
+  }
+
+  return (g->current);
+}
+
+int GovernorLevel(const Governor *governor) { return (governor->current); }
+
+double GovernorAverage(const Governor *governor) {
+  return (governor->average);
+}
@@ -0,0 +1,41 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <stdint.h>
+
+/*
+ *  Quality governor, one per clock.
+ *
+ *  Picks one of nLevels quality levels, 0 being the cheapest, from the
+ *  measured presentation latency of each frame.  The latency is
+ *  averaged (exponentially weighted) and compared with the frame
+ *  period: a server that takes longer than a frame to catch up gets a
+ *  cheaper level, and one that keeps up with plenty to spare gets a
+ *  better one.  After every change the governor waits for the average
+ *  to settle before it moves again, and a climb that has to be undone
+ *  straight away doubles the wait before the next one, so it does not
+ *  oscillate.
+ */
+#define GOVERNOR_ALPHA 0.1           /*  Weight of the newest sample       */
+#define GOVERNOR_DEGRADE 1.0         /*  Drop when latency > this * period */
+#define GOVERNOR_CLIMB 0.25          /*  Climb when latency < this*period  */
+#define GOVERNOR_SETTLE 40           /*  Frames to wait after any change   */
+#define GOVERNOR_CLIMB_WAIT 200      /*  Frames of headroom before a climb */
+#define GOVERNOR_MAX_CLIMB_WAIT 6400
+
+typedef struct {
+  int levels;
+  int current;
+  double average;  /*  Latency, ns               */
+  int sinceChange; /*  Frames at this level      */
+  int sinceStrain; /*  Frames with headroom      */
+  int climbWait;   /*  Headroom needed to climb  */
+  int climbed;     /*  Last change was a climb   */
+} Governor;
+
+void GovernorInit(Governor *governor, int nLevels, int level);
+int GovernorUpdate(Governor *governor, int64_t latency, int64_t period);
+int GovernorLevel(const Governor *governor);
+double GovernorAverage(const Governor *governor);
+
+#endif
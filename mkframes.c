@@ -0,0 +1,80 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "catrender.h"
+
+/*
+ *  mkframes - Writes the header of prerendered tail and eye frames,
+ *  one table per tail count given on the command line, so xclock can
+ *  start without rendering them.  Tables are at natural size.
+ *
+ *    mkframes 40 > catframes.h
+ */
+
+static void WriteFrames(const char *name, const char *bytesName, int nTails,
+                        RasterBitmap *(*render)(double, double)) {
+  int i, j;
+
+  printf("static const unsigned char %s%d[%d][%s] = {\n", name, nTails,
+         nTails + 1, bytesName);
+
+  for (i = 0; i <= nTails; i++) {
+    RasterBitmap *bitmap = render(i * M_PI / nTails, 1.0);
+    int bytes = bitmap->stride * bitmap->height;
+
+    printf("  {");
+    for (j = 0; j < bytes; j++) {
+      printf("%s0x%02x,", j % 12 == 0 ? "\n    " : " ", bitmap->bits[j]);
+    }
+    printf("\n  },\n");
+
+    RasterBitmapDestroy(bitmap);
+  }
+  printf("};\n\n");
+}
+
+int main(int argc, char **argv) {
+  RasterBitmap *tail, *eyes;
+  int i;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s nTails ...\n", argv[0]);
+    return (1);
+  }
+
+  tail = CatRenderTail(0.0, 1.0);
+  eyes = CatRenderEyes(0.0, 1.0);
+
+  printf("/*\n *  Generated by mkframes; do not edit.\n */\n\n");
+  printf("#define TAIL_FRAME_BYTES %d\n", tail->stride * tail->height);
+  printf("#define EYE_FRAME_BYTES %d\n\n", eyes->stride * eyes->height);
+
+  for (i = 1; i < argc; i++) {
+    int nTails = atoi(argv[i]);
+
+    if (nTails <= 0) {
+      fprintf(stderr, "%s: bad tail count %s\n", argv[0], argv[i]);
+      return (1);
+    }
+    WriteFrames("catTails", "TAIL_FRAME_BYTES", nTails, CatRenderTail);
+    WriteFrames("catEyes", "EYE_FRAME_BYTES", nTails, CatRenderEyes);
+  }
+
+  printf("static const struct {\n"
+         "  int nTails;\n"
+         "  const unsigned char *tails;\n"
+         "  const unsigned char *eyes;\n"
+         "} catFrameTables[] = {\n");
+  for (i = 1; i < argc; i++) {
+    int nTails = atoi(argv[i]);
+
+    printf("    {%d, catTails%d[0], catEyes%d[0]},\n", nTails, nTails, nTails);
+  }
+  printf("};\n\n#define N_CAT_FRAME_TABLES %d\n", argc - 1);
+
+  RasterBitmapDestroy(tail);
+  RasterBitmapDestroy(eyes);
+
+  return (0);
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+
+#include <X11/Xatom.h>
+
+#include "present.h"
+#include "timing.h"
+#include "trace.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+Presenter *PresentCreate(Display *dpy, Window window, int maxInFlight) {
+  Presenter *present;
+
+  present = (Presenter *)calloc(1, sizeof(Presenter));
+  present->dpy = dpy;
+  present->window = window;
+  present->fenceAtom = XInternAtom(dpy, "_CATCLOCK_FENCE", False);
+
+  present->maxFrames = max(maxInFlight, 0);
+  present->maxFrames = min(present->maxFrames, MAX_FRAMES_IN_FLIGHT);
+
+  return (present);
+}
+
+/*
+ *  Retire - Drops every fence the server has executed, serial included.
+ */
+static void Retire(Presenter *present, unsigned long serial) {
+  while (present->fenceCount > 0 &&
+         present->fenceSerial[present->fenceHead] <= serial) {
+    present->latency = TimingNow() - present->fenceTime[present->fenceHead];
+    present->fenceHead = (present->fenceHead + 1) % MAX_FRAMES_IN_FLIGHT;
+    present->fenceCount--;
+  }
+}
+
+static Bool IsFence(Display *dpy, XEvent *event, XPointer arg) {
+  Presenter *present = (Presenter *)arg;
+
+  (void *)dpy;
+
+  return (event->type == PropertyNotify &&
+          event->xproperty.window == present->window &&
+          event->xproperty.atom == present->fenceAtom);
+}
+
+/*
+ *  PresentFrame - Ends a frame.  Call after all of its drawing.
+ */
+void PresentFrame(Presenter *present) {
+  XEvent event;
+  int slot;
+
+  if (present->maxFrames == 0) {
+    int64_t start = TimingNow();
+
+    XSync(present->dpy, False);
+    present->latency = TimingNow() - start;
+    TraceEnd("XSync", start, present->traceTrack);
+    return;
+  }
+
+  /*
+   *  Backpressure: the server is maxFrames behind, wait for the oldest
+   */
+  if (present->fenceCount >= present->maxFrames) {
+    int64_t traceStart = TraceBegin();
+
+    while (present->fenceCount >= present->maxFrames) {
+      XIfEvent(present->dpy, &event, IsFence, (XPointer)present);
+      Retire(present, event.xproperty.serial);
+    }
+    TraceEnd("fence wait", traceStart, present->traceTrack);
+  }
+
+  present->frame++;
+  slot = (present->fenceHead + present->fenceCount) % MAX_FRAMES_IN_FLIGHT;
+  present->fenceSerial[slot] = NextRequest(present->dpy);
+  present->fenceTime[slot] = TimingNow();
+  present->fenceCount++;
+
+  XChangeProperty(present->dpy, present->window, present->fenceAtom,
+                  XA_INTEGER, 32, PropModeReplace,
+                  (unsigned char *)&present->frame, 1);
+  XFlush(present->dpy);
+}
+
+/*
+ *  PresentFenceEvent - Feed PropertyNotify events here; returns True if
+ *  the event was one of our fences.
+ */
+Bool PresentFenceEvent(Presenter *present, XEvent *event) {
+  if (!IsFence(present->dpy, event, (XPointer)present)) {
+    return (False);
+  }
+
+  Retire(present, event->xproperty.serial);
+
+  return (True);
+}
+
+int PresentInFlight(const Presenter *present) { return (present->fenceCount); }
+
+int64_t PresentLatency(const Presenter *present) { return (present->latency); }
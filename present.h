@@ -0,0 +1,47 @@
+#ifndef PRESENT_H
+#define PRESENT_H
+
+#include <stdint.h>
+
+#include <X11/Xlib.h>
+
+/*
+ *  Pipelined frame presentation.
+ *
+ *  Each frame ends with a fence: a tiny ChangeProperty on the clock
+ *  window.  The server answers with a PropertyNotify once it has
+ *  executed everything up to and including that frame, so frames are
+ *  only flushed, never synced, and we block only when more than
+ *  maxInFlight of them are still queued in the server.  There is one
+ *  Presenter per clock window.
+ */
+#define DEF_FRAMES_IN_FLIGHT 2
+#define MAX_FRAMES_IN_FLIGHT 16
+
+typedef struct {
+  Display *dpy;
+  Window window;
+  Atom fenceAtom;
+  int maxFrames; /*  0 = sync every frame    */
+  long frame;
+
+  /*
+   *  Ring of outstanding fences, oldest first
+   */
+  unsigned long fenceSerial[MAX_FRAMES_IN_FLIGHT];
+  int64_t fenceTime[MAX_FRAMES_IN_FLIGHT];
+  int fenceHead;
+  int fenceCount;
+
+  int64_t latency; /*  Last fence round trip   */
+
+  int traceTrack; /*  Where waits are traced  */
+} Presenter;
+
+Presenter *PresentCreate(Display *dpy, Window window, int maxInFlight);
+void PresentFrame(Presenter *present);
+Bool PresentFenceEvent(Presenter *present, XEvent *event);
+int PresentInFlight(const Presenter *present);
+int64_t PresentLatency(const Presenter *present);
+
+#endif
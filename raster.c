@@ -0,0 +1,390 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raster.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+typedef void (*SpanProc)(void *closure, int y, int x0, int x1);
+
+typedef struct {
+  RasterImage *image;
+  uint32_t color;
+} ImageSpan;
+
+RasterBitmap *RasterBitmapCreate(int width, int height) {
+  RasterBitmap *bitmap;
+
+  bitmap = (RasterBitmap *)malloc(sizeof(RasterBitmap));
+  bitmap->width = width;
+  bitmap->height = height;
+  bitmap->stride = (width + 7) / 8;
+  bitmap->bits = (unsigned char *)calloc(bitmap->stride * height, 1);
+
+  return (bitmap);
+}
+
+RasterBitmap *RasterBitmapFromData(const char *bits, int width, int height) {
+  RasterBitmap *bitmap;
+
+  bitmap = RasterBitmapCreate(width, height);
+  memcpy(bitmap->bits, bits, bitmap->stride * height);
+
+  return (bitmap);
+}
+
+void RasterBitmapCopy(RasterBitmap *dst, const RasterBitmap *src) {
+  memcpy(dst->bits, src->bits, min(dst->height, src->height) * dst->stride);
+}
+
+/*
+ *  RasterBitmapScale - A width x height copy of src, nearest neighbour,
+ *  so the hard edges of the cat's artwork stay hard at any size.
+ */
+RasterBitmap *RasterBitmapScale(const RasterBitmap *src, int width,
+                                int height) {
+  RasterBitmap *bitmap;
+  int x, y;
+
+  bitmap = RasterBitmapCreate(width, height);
+
+  for (y = 0; y < height; y++) {
+    unsigned char *row = bitmap->bits + y * bitmap->stride;
+    int sy = (int)((long)y * src->height / height);
+
+    for (x = 0; x < width; x++) {
+      if (RasterBitmapGet(src, (int)((long)x * src->width / width), sy)) {
+        row[x >> 3] |= 1 << (x & 7);
+      }
+    }
+  }
+
+  return (bitmap);
+}
+
+void RasterBitmapDestroy(RasterBitmap *bitmap) {
+  if (bitmap) {
+    free(bitmap->bits);
+    free(bitmap);
+  }
+}
+
+static void SetBitmapSpan(void *closure, int y, int x0, int x1) {
+  RasterBitmap *bitmap = (RasterBitmap *)closure;
+  unsigned char *row = bitmap->bits + y * bitmap->stride;
+  int x;
+
+  for (x = x0; x < x1; x++) {
+    row[x >> 3] |= 1 << (x & 7);
+  }
+}
+
+static void SetImageSpan(void *closure, int y, int x0, int x1) {
+  ImageSpan *span = (ImageSpan *)closure;
+  uint32_t *row = span->image->pixels + y * span->image->stride;
+  int x;
+
+  for (x = x0; x < x1; x++) {
+    row[x] = span->color;
+  }
+}
+
+static int CompareDouble(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+
+  return (da < db ? -1 : da > db ? 1 : 0);
+}
+
+/*
+ *  PolygonSpans - Scan converts a polygon with the even-odd rule (the
+ *  default GC fill rule), calling proc for every horizontal run of
+ *  pixels whose centers lie inside.  x1 is exclusive.
+ */
+static void PolygonSpans(const XPoint *pts, int n, int width, int height,
+                         SpanProc proc, void *closure) {
+  double *xs;
+  int ymin, ymax, y;
+  int i, k, nx;
+
+  if (n < 3) {
+    return;
+  }
+
+  ymin = ymax = pts[0].y;
+  for (i = 1; i < n; i++) {
+    ymin = min(ymin, pts[i].y);
+    ymax = max(ymax, pts[i].y);
+  }
+  ymin = max(ymin, 0);
+  ymax = min(ymax, height);
+
+  xs = (double *)malloc(n * sizeof(double));
+
+  for (y = ymin; y < ymax; y++) {
+    nx = 0;
+    for (i = 0; i < n; i++) {
+      const XPoint *p0 = &pts[i];
+      const XPoint *p1 = &pts[(i + 1) % n];
+
+      if ((y >= p0->y && y < p1->y) || (y >= p1->y && y < p0->y)) {
+        xs[nx++] = p0->x + (double)(y - p0->y) * (p1->x - p0->x) /
+                               (double)(p1->y - p0->y);
+      }
+    }
+
+    qsort(xs, nx, sizeof(double), CompareDouble);
+
+    for (k = 0; k + 1 < nx; k += 2) {
+      int x0 = max((int)ceil(xs[k]), 0);
+      int x1 = min((int)ceil(xs[k + 1]), width);
+
+      if (x0 < x1) {
+        proc(closure, y, x0, x1);
+      }
+    }
+  }
+
+  free(xs);
+}
+
+/*
+ *  RasterBitmapWideLines - Strokes a polyline with round caps and round
+ *  joins.  With both round, the stroke is simply every pixel within
+ *  lineWidth / 2 of some segment of the path.
+ */
+void RasterBitmapWideLines(RasterBitmap *bitmap, const XPoint *pts, int n,
+                           int lineWidth) {
+  double r = lineWidth / 2.0;
+  int i;
+
+  for (i = 0; i < max(n - 1, 1) && n > 0; i++) {
+    const XPoint *p0 = &pts[i];
+    const XPoint *p1 = &pts[min(i + 1, n - 1)];
+    double dx = p1->x - p0->x;
+    double dy = p1->y - p0->y;
+    double len2 = dx * dx + dy * dy;
+    int x0 = max((int)floor(min(p0->x, p1->x) - r), 0);
+    int x1 = min((int)ceil(max(p0->x, p1->x) + r), bitmap->width - 1);
+    int y0 = max((int)floor(min(p0->y, p1->y) - r), 0);
+    int y1 = min((int)ceil(max(p0->y, p1->y) + r), bitmap->height - 1);
+    int x, y;
+
+    for (y = y0; y <= y1; y++) {
+      unsigned char *row = bitmap->bits + y * bitmap->stride;
+
+      for (x = x0; x <= x1; x++) {
+        double t = 0.0;
+        double ex, ey;
+
+        if (len2 > 0.0) {
+          t = ((x - p0->x) * dx + (y - p0->y) * dy) / len2;
+          t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0 : t;
+        }
+        ex = x - (p0->x + t * dx);
+        ey = y - (p0->y + t * dy);
+
+        if (ex * ex + ey * ey <= r * r) {
+          row[x >> 3] |= 1 << (x & 7);
+        }
+      }
+    }
+  }
+}
+
+void RasterBitmapFillPolygon(RasterBitmap *bitmap, const XPoint *pts, int n) {
+  PolygonSpans(pts, n, bitmap->width, bitmap->height, SetBitmapSpan, bitmap);
+}
+
+RasterImage *RasterImageCreate(int width, int height) {
+  RasterImage *image;
+
+  image = RasterImageWrap(
+      (uint32_t *)calloc((size_t)width * height, sizeof(uint32_t)), width,
+      height, width);
+  image->owner = 1;
+
+  return (image);
+}
+
+RasterImage *RasterImageWrap(uint32_t *pixels, int width, int height,
+                             int stride) {
+  RasterImage *image;
+
+  image = (RasterImage *)malloc(sizeof(RasterImage));
+  image->width = width;
+  image->height = height;
+  image->stride = stride;
+  image->pixels = pixels;
+  image->owner = 0;
+
+  return (image);
+}
+
+void RasterImageDestroy(RasterImage *image) {
+  if (image) {
+    if (image->owner) {
+      free(image->pixels);
+    }
+    free(image);
+  }
+}
+
+void RasterFill(RasterImage *image, uint32_t color) {
+  int x, y;
+
+  for (y = 0; y < image->height; y++) {
+    uint32_t *row = image->pixels + y * image->stride;
+
+    for (x = 0; x < image->width; x++) {
+      row[x] = color;
+    }
+  }
+}
+
+void RasterCopyArea(RasterImage *dst, const RasterImage *src, int sx, int sy,
+                    int width, int height, int dx, int dy) {
+  int y;
+
+  width = min(width, min(src->width - sx, dst->width - dx));
+  height = min(height, min(src->height - sy, dst->height - dy));
+
+  for (y = 0; y < height; y++) {
+    memcpy(dst->pixels + (dy + y) * dst->stride + dx,
+           src->pixels + (sy + y) * src->stride + sx,
+           width * sizeof(uint32_t));
+  }
+}
+
+/*
+ *  Stipple fills cover the whole image with the tile/stipple origin at
+ *  0,0, which is the only way the cat uses them.
+ */
+void RasterFillStippled(RasterImage *image, const RasterBitmap *stipple,
+                        uint32_t fg) {
+  int x, y;
+
+  for (y = 0; y < image->height; y++) {
+    uint32_t *row = image->pixels + y * image->stride;
+    int sy = y % stipple->height;
+
+    for (x = 0; x < image->width; x++) {
+      if (RasterBitmapGet(stipple, x % stipple->width, sy)) {
+        row[x] = fg;
+      }
+    }
+  }
+}
+
+void RasterFillOpaqueStippled(RasterImage *image, const RasterBitmap *stipple,
+                              uint32_t fg, uint32_t bg) {
+  int x, y;
+
+  for (y = 0; y < image->height; y++) {
+    uint32_t *row = image->pixels + y * image->stride;
+    int sy = y % stipple->height;
+
+    for (x = 0; x < image->width; x++) {
+      row[x] = RasterBitmapGet(stipple, x % stipple->width, sy) ? fg : bg;
+    }
+  }
+}
+
+void RasterCopyPlane(RasterImage *dst, const RasterBitmap *src, int sx, int sy,
+                     int width, int height, int dx, int dy, uint32_t fg,
+                     uint32_t bg) {
+  int x, y;
+
+  width = min(width, min(src->width - sx, dst->width - dx));
+  height = min(height, min(src->height - sy, dst->height - dy));
+
+  for (y = 0; y < height; y++) {
+    uint32_t *row = dst->pixels + (dy + y) * dst->stride + dx;
+
+    for (x = 0; x < width; x++) {
+      row[x] = RasterBitmapGet(src, sx + x, sy + y) ? fg : bg;
+    }
+  }
+}
+
+void RasterFillPolygon(RasterImage *image, const XPoint *pts, int n,
+                       uint32_t color) {
+  ImageSpan span;
+
+  span.image = image;
+  span.color = color;
+  PolygonSpans(pts, n, image->width, image->height, SetImageSpan, &span);
+}
+
+/*
+ *  RasterDrawLines - Zero-width polyline (Bresenham, both endpoints drawn).
+ */
+void RasterDrawLines(RasterImage *image, const XPoint *pts, int n,
+                     uint32_t color) {
+  int i;
+
+  for (i = 0; i < n - 1; i++) {
+    int x = pts[i].x, y = pts[i].y;
+    int x1 = pts[i + 1].x, y1 = pts[i + 1].y;
+    int dx = abs(x1 - x), sx = x < x1 ? 1 : -1;
+    int dy = -abs(y1 - y), sy = y < y1 ? 1 : -1;
+    int err = dx + dy;
+    int e2;
+
+    for (;;) {
+      if (x >= 0 && x < image->width && y >= 0 && y < image->height) {
+        image->pixels[y * image->stride + x] = color;
+      }
+      if (x == x1 && y == y1) {
+        break;
+      }
+      e2 = 2 * err;
+      if (e2 >= dy) {
+        err += dy;
+        x += sx;
+      }
+      if (e2 <= dx) {
+        err += dx;
+        y += sy;
+      }
+    }
+  }
+}
+
+/*
+ *  RasterHostByteOrder - LSBFirst or MSBFirst, as the pixels of a
+ *  RasterImage lie in memory, for XImages that point at them.
+ */
+int RasterHostByteOrder(void) {
+  int one = 1;
+
+  return (*(char *)&one == 1 ? LSBFirst : MSBFirst);
+}
+
+/*
+ *  RasterWritePPM - Dumps an 0xAARRGGBB image as a binary PPM.
+ */
+int RasterWritePPM(const RasterImage *image, FILE *fp) {
+  unsigned char *rgb;
+  int x, y;
+
+  rgb = (unsigned char *)malloc(image->width * 3);
+
+  fprintf(fp, "P6\n%d %d\n255\n", image->width, image->height);
+  for (y = 0; y < image->height; y++) {
+    const uint32_t *row = image->pixels + y * image->stride;
+
+    for (x = 0; x < image->width; x++) {
+      rgb[3 * x + 0] = (row[x] >> 16) & 0xff;
+      rgb[3 * x + 1] = (row[x] >> 8) & 0xff;
+      rgb[3 * x + 2] = row[x] & 0xff;
+    }
+    fwrite(rgb, 3, image->width, fp);
+  }
+
+  free(rgb);
+
+  return (ferror(fp) ? -1 : 0);
+}
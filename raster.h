@@ -0,0 +1,79 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <X11/Xlib.h>
+
+/*
+ *  Software rasterizer.
+ *
+ *  These routines reproduce, in client memory, the handful of X drawing
+ *  operations the cat is built from.  Sampling follows the X rules: a
+ *  pixel is painted when its center, at integer coordinates, falls inside
+ *  the shape (left/top edges inclusive, right/bottom edges exclusive).
+ */
+
+/*
+ *  1-bit image, laid out exactly like XBM data (rows padded to a byte,
+ *  least significant bit first) so it can be handed straight to
+ *  XCreateBitmapFromData or XPutImage.
+ */
+typedef struct {
+  int width;
+  int height;
+  int stride;          /*  Bytes per row           */
+  unsigned char *bits; /*  1 = foreground          */
+} RasterBitmap;
+
+/*
+ *  32-bit image.  Pixel values are opaque to the rasterizer: headless
+ *  callers store 0xAARRGGBB, the X paths store server Pixel values.
+ */
+typedef struct {
+  int width;
+  int height;
+  int stride;       /*  Pixels per row          */
+  uint32_t *pixels; /*  Row-major               */
+  int owner;        /*  Free pixels on destroy? */
+} RasterImage;
+
+#define RasterBitmapGet(b, x, y)                                               \
+  (((b)->bits[(y) * (b)->stride + ((x) >> 3)] >> ((x)&7)) & 1)
+
+RasterBitmap *RasterBitmapCreate(int width, int height);
+RasterBitmap *RasterBitmapFromData(const char *bits, int width, int height);
+void RasterBitmapCopy(RasterBitmap *dst, const RasterBitmap *src);
+RasterBitmap *RasterBitmapScale(const RasterBitmap *src, int width,
+                                int height);
+void RasterBitmapDestroy(RasterBitmap *bitmap);
+
+void RasterBitmapWideLines(RasterBitmap *bitmap, const XPoint *pts, int n,
+                           int lineWidth);
+void RasterBitmapFillPolygon(RasterBitmap *bitmap, const XPoint *pts, int n);
+
+RasterImage *RasterImageCreate(int width, int height);
+RasterImage *RasterImageWrap(uint32_t *pixels, int width, int height,
+                             int stride);
+void RasterImageDestroy(RasterImage *image);
+
+void RasterFill(RasterImage *image, uint32_t color);
+void RasterCopyArea(RasterImage *dst, const RasterImage *src, int sx, int sy,
+                    int width, int height, int dx, int dy);
+void RasterFillStippled(RasterImage *image, const RasterBitmap *stipple,
+                        uint32_t fg);
+void RasterFillOpaqueStippled(RasterImage *image, const RasterBitmap *stipple,
+                              uint32_t fg, uint32_t bg);
+void RasterCopyPlane(RasterImage *dst, const RasterBitmap *src, int sx, int sy,
+                     int width, int height, int dx, int dy, uint32_t fg,
+                     uint32_t bg);
+void RasterFillPolygon(RasterImage *image, const XPoint *pts, int n,
+                       uint32_t color);
+void RasterDrawLines(RasterImage *image, const XPoint *pts, int n,
+                     uint32_t color);
+
+int RasterHostByteOrder(void);
+int RasterWritePPM(const RasterImage *image, FILE *fp);
+
+#endif
@@ -0,0 +1,231 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "renderahead.h"
+#include "timing.h"
+
+#define AHEAD_IDLE ((int64_t)50000000) /*  Longest nap, ns  */
+
+typedef struct {
+  FramePlan plans[AHEAD_PLANS];
+  atomic_uint head; /*  Next to take; only the X thread moves it   */
+  atomic_uint tail; /*  Next to fill; only the worker moves it     */
+
+  /*
+   *  The worker's own
+   */
+  unsigned generation; /*  Of the plans it is making      */
+  int64_t period;      /*  And the deadlines they are for */
+  int64_t next;
+  FramePlan prev;
+  Bool havePrev;
+} PlanRing;
+
+struct _RenderAhead {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  PlanProc proc;
+  void *closure;
+
+  atomic_llong deadline; /*  Last one the scheduler fired for  */
+  atomic_llong period;
+  atomic_uint generation; /*  Moved under lock                  */
+
+  int nRings;
+  PlanRing *rings;
+};
+
+/*
+ *  Fill - Plans the next deadline of ring i if there is room.  Returns
+ *  whether it did.
+ */
+static Bool Fill(RenderAhead *ahead, int i) {
+  PlanRing *ring = &ahead->rings[i];
+  int64_t deadline = atomic_load(&ahead->deadline);
+  int64_t period = atomic_load(&ahead->period);
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  FramePlan *plan;
+
+  if (period <= 0 || tail - head >= AHEAD_PLANS) {
+    return (False);
+  }
+
+  pthread_mutex_lock(&ahead->lock);
+
+  /*
+   *  Start over on the scheduler's grid after a change, and catch up
+   *  if the X thread got ahead of us
+   */
+  if (ring->generation != atomic_load(&ahead->generation) ||
+      ring->period != period || (ring->next - deadline) % period != 0) {
+    ring->generation = atomic_load(&ahead->generation);
+    ring->period = period;
+    ring->next = deadline + period;
+    ring->havePrev = False;
+  } else if (ring->next <= deadline) {
+    ring->next = deadline + period;
+  }
+
+  plan = &ring->plans[tail % AHEAD_PLANS];
+  (*ahead->proc)(ahead->closure, i, ring->next,
+                 ring->havePrev ? &ring->prev : NULL, plan);
+  plan->when = ring->next;
+  plan->generation = ring->generation;
+
+  pthread_mutex_unlock(&ahead->lock);
+
+  ring->prev = *plan;
+  ring->havePrev = True;
+  ring->next += period;
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+  return (True);
+}
+
+static void *Worker(void *closure) {
+  RenderAhead *ahead = (RenderAhead *)closure;
+  int64_t period;
+  Bool busy;
+  int i;
+
+  for (;;) {
+    busy = False;
+    for (i = 0; i < ahead->nRings; i++) {
+      busy |= Fill(ahead, i);
+    }
+
+    /*
+     *  Every ring is full: nothing will be taken for a period
+     */
+    if (!busy) {
+      period = atomic_load(&ahead->period);
+      TimingSleepUntil(TimingNow() +
+                       (period > 0 && period < AHEAD_IDLE ? period
+                                                          : AHEAD_IDLE));
+    }
+  }
+
+  return (NULL);
+}
+
+/*
+ *  RenderAheadStart - Starts a worker planning for nClocks clocks with
+ *  proc.  Nothing is planned until RenderAheadSchedule says when.
+ *  Returns NULL if there cannot be a thread.
+ */
+RenderAhead *RenderAheadStart(int nClocks, PlanProc proc, void *closure) {
+  RenderAhead *ahead = (RenderAhead *)calloc(1, sizeof(RenderAhead));
+  pthread_mutexattr_t attr;
+  int i;
+
+  ahead->proc = proc;
+  ahead->closure = closure;
+  ahead->nRings = nClocks;
+  ahead->rings = (PlanRing *)calloc(nClocks, sizeof(PlanRing));
+  for (i = 0; i < nClocks; i++) {
+    atomic_init(&ahead->rings[i].head, 0);
+    atomic_init(&ahead->rings[i].tail, 0);
+  }
+  atomic_init(&ahead->deadline, 0);
+  atomic_init(&ahead->period, 0);
+  atomic_init(&ahead->generation, 1);
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&ahead->lock, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  if (pthread_create(&ahead->thread, NULL, Worker, ahead) != 0) {
+    perror("xclock: render-ahead thread");
+    pthread_mutex_destroy(&ahead->lock);
+    free(ahead->rings);
+    free(ahead);
+    return (NULL);
+  }
+  pthread_detach(ahead->thread);
+
+  return (ahead);
+}
+
+/*
+ *  RenderAheadSchedule - Tells the worker the deadline the scheduler
+ *  just fired for and its period; the deadlines after it get planned.
+ */
+void RenderAheadSchedule(RenderAhead *ahead, int64_t deadline,
+                         int64_t period) {
+  if (ahead == NULL) {
+    return;
+  }
+
+  atomic_store(&ahead->period, period);
+  atomic_store(&ahead->deadline, deadline);
+}
+
+/*
+ *  RenderAheadTake - Takes the plan clock i has for deadline, dropping
+ *  the ones for deadlines gone by and the ones made before a change.
+ *  Returns False, and leaves later plans be, if there is none.
+ */
+Bool RenderAheadTake(RenderAhead *ahead, int i, int64_t deadline,
+                     FramePlan *plan) {
+  PlanRing *ring;
+  int64_t slack;
+  unsigned generation, head;
+  Bool take;
+
+  if (ahead == NULL) {
+    return (False);
+  }
+
+  ring = &ahead->rings[i];
+  slack = atomic_load(&ahead->period) / 2;
+  generation = atomic_load(&ahead->generation);
+
+  for (;;) {
+    FramePlan *p;
+
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head == atomic_load_explicit(&ring->tail, memory_order_acquire)) {
+      return (False);
+    }
+
+    p = &ring->plans[head % AHEAD_PLANS];
+    if (p->generation == generation && p->when > deadline + slack) {
+      return (False);
+    }
+    take = p->generation == generation && p->when >= deadline - slack;
+    if (take) {
+      *plan = *p;
+    }
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    if (take) {
+      return (True);
+    }
+  }
+}
+
+void RenderAheadLock(RenderAhead *ahead) {
+  if (ahead != NULL) {
+    pthread_mutex_lock(&ahead->lock);
+  }
+}
+
+void RenderAheadUnlock(RenderAhead *ahead) {
+  if (ahead != NULL) {
+    pthread_mutex_unlock(&ahead->lock);
+  }
+}
+
+/*
+ *  RenderAheadChanged - Drops every plan made so far; call with the
+ *  lock held, after changing what plans are made from.
+ */
+void RenderAheadChanged(RenderAhead *ahead) {
+  if (ahead != NULL) {
+    atomic_fetch_add(&ahead->generation, 1);
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef RENDERAHEAD_H
+#define RENDERAHEAD_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "catrender.h"
+#include "frames.h"
+
+/*
+ *  Render-ahead worker.
+ *
+ *  A thread that works out frames before their deadlines, so that a
+ *  spike in that work (rendering and diffing the frames of a new scale
+ *  or level, the hand geometry) lands between deadlines instead of
+ *  delaying a frame.  It keeps one ring of AHEAD_PLANS FramePlans per
+ *  clock filled, for the deadlines the scheduler will fire next; each
+ *  ring has one producer and one consumer and takes no lock.  At its
+ *  deadline the X thread takes the plan and only has to make the
+ *  requests: every X call stays on the X thread.
+ *
+ *  Plans are made by a PlanProc from what the lock guards (frame sets,
+ *  levels, layouts).  The X thread changes those only holding the lock,
+ *  and calls RenderAheadChanged before letting go, which drops every
+ *  plan made earlier.  The lock is recursive; it and all the other
+ *  calls do nothing on a NULL RenderAhead, so the X thread can make the
+ *  same calls whether or not there is a worker.
+ */
+#define AHEAD_PLANS 16 /*  Per clock; a power of two  */
+
+typedef struct {
+  int64_t when;        /*  Deadline it is for         */
+  unsigned generation; /*  RenderAheadChanged count   */
+  struct tm tm;        /*  Local time at when         */
+  long nsec;           /*  And how far into its second */
+  int tail;            /*  Pendulum frame             */
+  int fromTail;        /*  Frame the deltas go from   */
+  const FrameDelta *tailDelta;
+  const FrameDelta *eyeDelta;
+  XPoint hands[2 * (VERTICES_IN_HANDS + 2)]; /*  Minute, hour  */
+  XPoint second[SECOND_HAND_PTS];
+} FramePlan;
+
+/*
+ *  Called on the worker, holding the lock, to plan frame when of clock
+ *  i; prev is the plan made before it, or NULL.
+ */
+typedef void (*PlanProc)(void *closure, int i, int64_t when,
+                         const FramePlan *prev, FramePlan *plan);
+
+typedef struct _RenderAhead RenderAhead;
+
+RenderAhead *RenderAheadStart(int nClocks, PlanProc proc, void *closure);
+void RenderAheadSchedule(RenderAhead *ahead, int64_t deadline,
+                         int64_t period);
+Bool RenderAheadTake(RenderAhead *ahead, int i, int64_t deadline,
+                     FramePlan *plan);
+void RenderAheadLock(RenderAhead *ahead);
+void RenderAheadUnlock(RenderAhead *ahead);
+void RenderAheadChanged(RenderAhead *ahead);
+
+#endif
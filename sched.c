@@ -0,0 +1,180 @@
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+#include "sched.h"
+#include "timing.h"
+#include "trace.h"
+
+#define JUMP_THRESHOLD 1000000000 /*  Wall clock slop, ns     */
+
+static XtAppContext schedApp;
+static SchedProc schedProc;
+static XtPointer schedClosure;
+
+static int64_t period;   /*  Nanoseconds             */
+static int64_t deadline; /*  Next monotonic deadline */
+
+static int64_t lastMono; /*  Clocks at last firing   */
+static int64_t lastReal;
+static int64_t lateness; /*  Of the last firing      */
+
+#ifdef __linux__
+static int timerFd = -1;
+#else
+static XtIntervalId timerId = 0;
+#endif
+
+static int64_t RealNow(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  return ((int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+/*
+ *  Fire - Common tail of both timer flavours.
+ */
+static void Fire(int skipped) {
+  int64_t mono = TimingNow();
+  int64_t real = RealNow();
+  int64_t drift = (real - lastReal) - (mono - lastMono);
+  Boolean jumped = drift > JUMP_THRESHOLD || drift < -JUMP_THRESHOLD;
+
+  lastMono = mono;
+  lastReal = real;
+  lateness = mono - (deadline - period);
+
+  /*
+   *  How late the deadline that just passed was served
+   */
+  if (traceEnabled) {
+    TraceSpan("timer late", mono - lateness, mono, TRACE_SCHED);
+  }
+
+  (*schedProc)(schedClosure, skipped, jumped);
+}
+
+#ifdef __linux__
+
+static void Arm(void) {
+  struct itimerspec its;
+
+  its.it_value.tv_sec = deadline / 1000000000;
+  its.it_value.tv_nsec = deadline % 1000000000;
+  its.it_interval.tv_sec = period / 1000000000;
+  its.it_interval.tv_nsec = period % 1000000000;
+
+  timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void TimerInput(XtPointer closure, int *fd, XtInputId *id) {
+  uint64_t expirations = 0;
+
+  (void *)closure;
+  (void *)id;
+
+  if (read(*fd, &expirations, sizeof(expirations)) != sizeof(expirations) ||
+      expirations == 0) {
+    return;
+  }
+
+  deadline += (int64_t)expirations * period;
+  Fire((int)(expirations - 1));
+}
+
+#else
+
+/*
+ *  Without timerfd, fall back to relative Xt timeouts recomputed from
+ *  the absolute deadline each time, which at least does not drift.
+ */
+static void TimerTimeOut(XtPointer closure, XtIntervalId *id);
+
+static void Arm(void) {
+  int64_t delay = deadline - TimingNow();
+
+  if (timerId) {
+    XtRemoveTimeOut(timerId);
+  }
+  timerId = XtAppAddTimeOut(
+      schedApp, delay > 0 ? (unsigned long)((delay + 999999) / 1000000) : 0,
+      TimerTimeOut, NULL);
+}
+
+static void TimerTimeOut(XtPointer closure, XtIntervalId *id) {
+  int64_t now = TimingNow();
+  int skipped = 0;
+
+  (void *)closure;
+  (void *)id;
+
+  timerId = 0;
+  if (now > deadline) {
+    skipped = (int)((now - deadline) / period);
+  }
+  deadline += (skipped + 1) * period;
+
+  Arm();
+  Fire(skipped);
+}
+
+#endif
+
+void SchedStart(XtAppContext app, int64_t newPeriod, SchedProc proc,
+                XtPointer closure) {
+  schedApp = app;
+  schedProc = proc;
+  schedClosure = closure;
+  period = newPeriod;
+
+  lastMono = TimingNow();
+  lastReal = RealNow();
+  deadline = lastMono + period;
+
+#ifdef __linux__
+  timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  XtAppAddInput(schedApp, timerFd, (XtPointer)XtInputReadMask, TimerInput,
+                NULL);
+#endif
+
+  Arm();
+}
+
+/*
+ *  SchedSetPeriod - Changes the period; the next deadline is one new
+ *  period from now.
+ */
+void SchedSetPeriod(int64_t newPeriod) {
+  period = newPeriod;
+  deadline = TimingNow() + period;
+
+  Arm();
+}
+
+/*
+ *  SchedSetPeriodAligned - Changes the period, with deadlines falling on
+ *  wall clock multiples of it (a 60 second period fires on the minute).
+ */
+void SchedSetPeriodAligned(int64_t newPeriod) {
+  period = newPeriod;
+  deadline = TimingNow() + period - RealNow() % period;
+
+  Arm();
+}
+
+int64_t SchedGetPeriod(void) { return (period); }
+
+/*
+ *  SchedDeadline - The deadline proc was last called for.
+ */
+int64_t SchedDeadline(void) { return (deadline - period); }
+
+/*
+ *  SchedLateness - How long after its deadline proc was last called.
+ */
+int64_t SchedLateness(void) { return (lateness); }
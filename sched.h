@@ -0,0 +1,27 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+#include <X11/Intrinsic.h>
+
+/*
+ *  Frame scheduler.
+ *
+ *  Fires proc on absolute CLOCK_MONOTONIC deadlines, period nanoseconds
+ *  apart.  Deadlines that have already passed are not replayed: proc is
+ *  called once and told how many were skipped.  jumped is set when the
+ *  wall clock moved by something other than the elapsed monotonic time
+ *  (settimeofday, NTP steps, suspend and resume).
+ */
+typedef void (*SchedProc)(XtPointer closure, int skipped, Boolean jumped);
+
+void SchedStart(XtAppContext app, int64_t period, SchedProc proc,
+                XtPointer closure);
+void SchedSetPeriod(int64_t period);
+void SchedSetPeriodAligned(int64_t period);
+int64_t SchedGetPeriod(void);
+int64_t SchedDeadline(void);
+int64_t SchedLateness(void);
+
+#endif
@@ -0,0 +1,253 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+
+#include "sharecache.h"
+
+#define ENTRY_SIZE (SHARE_KEY_SIZE + 1) /*  Key, then the pixmap  */
+#define MAX_CACHE_WORDS 4096
+
+static Bool cacheError = False; /*  Set by CacheErrorHandler  */
+
+static int CacheErrorHandler(Display *dpy, XErrorEvent *event) {
+  (void *)dpy;
+  (void *)event;
+
+  cacheError = True;
+
+  return (0);
+}
+
+/*
+ *  ValidPixmap - Whether pixmap still exists on the screen of root,
+ *  with the size and depth its entry was published with.  A pixmap
+ *  that has been freed answers with an error instead, which must not
+ *  reach the application's error handler.
+ */
+static Bool ValidPixmap(Display *dpy, Window root, Pixmap pixmap,
+                        unsigned int width, unsigned int height,
+                        unsigned int depth) {
+  XErrorHandler oldHandler;
+  Window pixmapRoot;
+  int x, y;
+  unsigned int w, h, border, d;
+  Status status;
+
+  XSync(dpy, False);
+  cacheError = False;
+  oldHandler = XSetErrorHandler(CacheErrorHandler);
+
+  status = XGetGeometry(dpy, pixmap, &pixmapRoot, &x, &y, &w, &h, &border, &d);
+
+  XSetErrorHandler(oldHandler);
+
+  return (status && !cacheError && pixmapRoot == root && w == width &&
+          h == height && d == depth);
+}
+
+/*
+ *  PixmapExists - Whether pixmap has not been freed or killed.
+ */
+static Bool PixmapExists(Display *dpy, Pixmap pixmap) {
+  XErrorHandler oldHandler;
+  Window root;
+  int x, y;
+  unsigned int w, h, border, d;
+  Status status;
+
+  XSync(dpy, False);
+  cacheError = False;
+  oldHandler = XSetErrorHandler(CacheErrorHandler);
+
+  status = XGetGeometry(dpy, pixmap, &root, &x, &y, &w, &h, &border, &d);
+
+  XSetErrorHandler(oldHandler);
+
+  return (status && !cacheError);
+}
+
+/*
+ *  FreeEntry - Frees the pixmap of an entry taken off the list, which
+ *  nobody could find again.  Whoever created it has gone, leaving it to
+ *  the server; it may have been killed since.
+ */
+static void FreeEntry(Display *owner, Pixmap pixmap) {
+  XErrorHandler oldHandler;
+
+  XSync(owner, False);
+  oldHandler = XSetErrorHandler(CacheErrorHandler);
+
+  XFreePixmap(owner, pixmap);
+  XSync(owner, False);
+
+  XSetErrorHandler(oldHandler);
+}
+
+/*
+ *  ReadCache - Fetches the entries published on root, or NULL if there
+ *  are none of this version.  The result is freed with XFree.
+ */
+static unsigned long *ReadCache(Display *dpy, Window root, int *nEntries) {
+  Atom type;
+  int format;
+  unsigned long nItems, after;
+  unsigned char *data = NULL;
+
+  *nEntries = 0;
+
+  if (XGetWindowProperty(dpy, root,
+                         XInternAtom(dpy, SHARE_CACHE_PROPERTY, False), 0,
+                         MAX_CACHE_WORDS, False, XA_CARDINAL, &type, &format,
+                         &nItems, &after, &data) != Success) {
+    return ((unsigned long *)NULL);
+  }
+
+  if (data == NULL || type != XA_CARDINAL || format != 32 || nItems < 1 ||
+      ((unsigned long *)data)[0] != SHARE_CACHE_VERSION) {
+    if (data != NULL) {
+      XFree(data);
+    }
+    return ((unsigned long *)NULL);
+  }
+
+  *nEntries = (nItems - 1) / ENTRY_SIZE;
+
+  return ((unsigned long *)data);
+}
+
+/*
+ *  ShareCacheFind - The pixmap published under key on the screen of
+ *  root, or None if there is none or it is no longer usable.  Costs a
+ *  round trip or two.
+ */
+Pixmap ShareCacheFind(Display *dpy, Window root, const unsigned long *key,
+                      unsigned int width, unsigned int height,
+                      unsigned int depth) {
+  unsigned long *cache;
+  Pixmap pixmap = None;
+  int nEntries, i;
+
+  cache = ReadCache(dpy, root, &nEntries);
+
+  for (i = 0; i < nEntries; i++) {
+    unsigned long *entry = cache + 1 + i * ENTRY_SIZE;
+
+    if (memcmp(entry, key, SHARE_KEY_SIZE * sizeof(unsigned long)) == 0) {
+      if (ValidPixmap(dpy, root, entry[SHARE_KEY_SIZE], width, height,
+                      depth)) {
+        pixmap = entry[SHARE_KEY_SIZE];
+      }
+      break;
+    }
+  }
+
+  if (cache != NULL) {
+    XFree(cache);
+  }
+
+  return (pixmap);
+}
+
+/*
+ *  ShareCacheOpen - A second connection to the server of dpy, for
+ *  creating pixmaps that outlive this process.  NULL if the server
+ *  will not take another client.
+ */
+Display *ShareCacheOpen(Display *dpy) {
+  Display *owner;
+
+  owner = XOpenDisplay(DisplayString(dpy));
+  if (owner != NULL) {
+    XSetCloseDownMode(owner, RetainPermanent);
+  }
+
+  return (owner);
+}
+
+/*
+ *  ShareCachePublish - Lists pixmap, made on owner, under key.  The
+ *  server is grabbed from reading the property to writing it back, so
+ *  two instances starting together cannot lose each other's entries.
+ *  If a usable pixmap turned up under key in the meantime, that one is
+ *  returned and the caller should free its own; otherwise pixmap is.
+ *
+ *  Entries whose pixmaps have gone are dropped.  A stale entry under
+ *  key, and the oldest entries once the property is full, are dropped
+ *  and their pixmaps freed, so none are left on the server unlisted.
+ */
+Pixmap ShareCachePublish(Display *owner, Window root, const unsigned long *key,
+                         Pixmap pixmap, unsigned int width,
+                         unsigned int height, unsigned int depth) {
+  unsigned long *cache, *data;
+  Pixmap existing;
+  int nEntries, nKept, n, i;
+
+  /*
+   *  The contents have to be in before anyone can see the entry
+   */
+  XSync(owner, False);
+
+  XGrabServer(owner);
+
+  existing = ShareCacheFind(owner, root, key, width, height, depth);
+
+  if (existing == None) {
+    cache = ReadCache(owner, root, &nEntries);
+
+    data = (unsigned long *)malloc((2 + nEntries * ENTRY_SIZE + ENTRY_SIZE) *
+                                   sizeof(unsigned long));
+    data[0] = SHARE_CACHE_VERSION;
+    n = 1;
+
+    /*
+     *  Keep everything else that is still there, newest last, leaving
+     *  room for the new entry
+     */
+    for (i = 0; i < nEntries; i++) {
+      unsigned long *entry = cache + 1 + i * ENTRY_SIZE;
+
+      if (!PixmapExists(owner, entry[SHARE_KEY_SIZE])) {
+        continue;
+      }
+      if (memcmp(entry, key, SHARE_KEY_SIZE * sizeof(unsigned long)) == 0) {
+        FreeEntry(owner, entry[SHARE_KEY_SIZE]);
+        continue;
+      }
+      memcpy(data + n, entry, ENTRY_SIZE * sizeof(unsigned long));
+      n += ENTRY_SIZE;
+    }
+
+    nKept = (n - 1) / ENTRY_SIZE;
+    for (i = 0; n + ENTRY_SIZE > MAX_CACHE_WORDS; i++) {
+      FreeEntry(owner, data[1 + i * ENTRY_SIZE + SHARE_KEY_SIZE]);
+      n -= ENTRY_SIZE;
+    }
+    memmove(data + 1, data + 1 + i * ENTRY_SIZE,
+            (nKept - i) * ENTRY_SIZE * sizeof(unsigned long));
+    memcpy(data + n, key, SHARE_KEY_SIZE * sizeof(unsigned long));
+    data[n + SHARE_KEY_SIZE] = pixmap;
+    n += ENTRY_SIZE;
+
+    XChangeProperty(owner, root,
+                    XInternAtom(owner, SHARE_CACHE_PROPERTY, False),
+                    XA_CARDINAL, 32, PropModeReplace, (unsigned char *)data,
+                    n);
+
+    free(data);
+    if (cache != NULL) {
+      XFree(cache);
+    }
+  }
+
+  XUngrabServer(owner);
+  XSync(owner, False);
+
+  return (existing != None ? existing : pixmap);
+}
+
+/*
+ *  ShareCacheClose - Closes owner.  What it created stays behind.
+ */
+void ShareCacheClose(Display *owner) { XCloseDisplay(owner); }
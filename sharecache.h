@@ -0,0 +1,49 @@
+#ifndef SHARECACHE_H
+#define SHARECACHE_H
+
+#include <X11/Xlib.h>
+
+/*
+ *  Frame cache shared by every catclock on one X server.
+ *
+ *  The first instance to need a pixmap that never changes (the atlases
+ *  of the default tail count, the body tile for a set of colors, at
+ *  the scale it starts at) creates it on a second connection whose
+ *  close down mode is RetainPermanent, and lists it in a property on
+ *  the root window.  Later instances find it there and use it instead
+ *  of making their own.  Entries are checked with XGetGeometry before
+ *  use, since the pixmaps go away with KillClient (xkill -a) while the
+ *  property stays; publishing drops such entries, and frees the oldest
+ *  pixmaps when the property is full.
+ *
+ *  The property holds SHARE_CACHE_VERSION followed by entries of
+ *  SHARE_KEY_SIZE key words and a pixmap ID.  The version changes
+ *  whenever the contents a key stands for would.
+ */
+#define SHARE_CACHE_PROPERTY "_CATCLOCK_FRAME_CACHE"
+#define SHARE_CACHE_VERSION 2
+
+#define SHARE_KEY_SIZE 6
+
+/*
+ *  The first key word is the kind of entry, the second its scale in
+ *  thousandths of natural size
+ */
+#define SHARE_TAILS 1 /*  Tail atlas; nTails          */
+#define SHARE_EYES 2  /*  Eye atlas; nTails           */
+#define SHARE_TILE 3  /*  Body tile; background, cat, */
+                      /*  detail and tie pixels       */
+#define SHARE_COLOR_TAILS 4 /*  Colored tail atlas; nTails, */
+#define SHARE_COLOR_EYES 5  /*  then set and clear pixels   */
+
+Pixmap ShareCacheFind(Display *dpy, Window root, const unsigned long *key,
+                      unsigned int width, unsigned int height,
+                      unsigned int depth);
+
+Display *ShareCacheOpen(Display *dpy);
+Pixmap ShareCachePublish(Display *owner, Window root, const unsigned long *key,
+                         Pixmap pixmap, unsigned int width,
+                         unsigned int height, unsigned int depth);
+void ShareCacheClose(Display *owner);
+
+#endif
@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <X11/Xutil.h>
+
+#include "shmframe.h"
+
+static Bool attachFailed;
+
+static int AttachError(Display *dpy, XErrorEvent *event) {
+  (void *)dpy;
+  (void *)event;
+
+  attachFailed = True;
+
+  return (0);
+}
+
+static void DestroyBuffer(ShmFrames *shm, int i) {
+  if (shm->rasters[i] != NULL) {
+    XShmDetach(shm->dpy, &shm->segments[i]);
+  }
+  if (shm->segments[i].shmaddr != NULL) {
+    shmdt(shm->segments[i].shmaddr);
+  }
+  if (shm->images[i] != NULL) {
+    shm->images[i]->data = NULL;
+    XDestroyImage(shm->images[i]);
+  }
+  RasterImageDestroy(shm->rasters[i]);
+
+  shm->images[i] = NULL;
+  shm->rasters[i] = NULL;
+  shm->segments[i].shmaddr = NULL;
+}
+
+/*
+ *  CreateBuffer - One shared image.  Only 32 bit pixels in host byte
+ *  order are handled; anything else is left to the X drawing path.
+ */
+static Bool CreateBuffer(ShmFrames *shm, int i, Visual *visual, int depth,
+                         int width, int height) {
+  XShmSegmentInfo *segment = &shm->segments[i];
+  XImage *image;
+  XErrorHandler oldHandler;
+
+  segment->shmaddr = NULL;
+  image = shm->images[i] = XShmCreateImage(shm->dpy, visual, depth, ZPixmap,
+                                           NULL, segment, width, height);
+  if (image == NULL || image->bits_per_pixel != 32 ||
+      image->byte_order != RasterHostByteOrder()) {
+    return (False);
+  }
+
+  segment->shmid =
+      shmget(IPC_PRIVATE, image->bytes_per_line * height, IPC_CREAT | 0600);
+  if (segment->shmid < 0) {
+    return (False);
+  }
+  segment->shmaddr = image->data = shmat(segment->shmid, NULL, 0);
+  segment->readOnly = False;
+  if (segment->shmaddr == (char *)-1) {
+    segment->shmaddr = NULL;
+    shmctl(segment->shmid, IPC_RMID, NULL);
+    return (False);
+  }
+
+  /*
+   *  A remote server will refuse the attach; find out now.
+   */
+  attachFailed = False;
+  oldHandler = XSetErrorHandler(AttachError);
+  XShmAttach(shm->dpy, segment);
+  XSync(shm->dpy, False);
+  XSetErrorHandler(oldHandler);
+
+  /*
+   *  Mark the segment for removal now; it lives until both sides detach
+   */
+  shmctl(segment->shmid, IPC_RMID, NULL);
+
+  if (attachFailed) {
+    return (False);
+  }
+
+  shm->rasters[i] = RasterImageWrap((uint32_t *)image->data, width, height,
+                                    image->bytes_per_line / 4);
+
+  return (True);
+}
+
+/*
+ *  ShmFrameCreate - Returns NULL, having cleaned up, if shared memory
+ *  images cannot be used with this display and visual.
+ */
+ShmFrames *ShmFrameCreate(Display *dpy, Visual *visual, int depth, int width,
+                          int height, int buffers) {
+  ShmFrames *shm;
+  int i;
+
+  if (!XShmQueryExtension(dpy)) {
+    return (NULL);
+  }
+
+  shm = (ShmFrames *)calloc(1, sizeof(ShmFrames));
+  shm->dpy = dpy;
+
+  buffers = buffers < 1 ? 1 : buffers;
+  buffers = buffers > MAX_SHM_BUFFERS ? MAX_SHM_BUFFERS : buffers;
+
+  for (i = 0; i < buffers; i++) {
+    if (!CreateBuffer(shm, i, visual, depth, width, height)) {
+      for (; i >= 0; i--) {
+        DestroyBuffer(shm, i);
+      }
+      free(shm);
+      return (NULL);
+    }
+  }
+
+  shm->nBuffers = buffers;
+  shm->current = -1;
+
+  return (shm);
+}
+
+/*
+ *  ShmFrameDestroy - Frees every buffer, once the server is done
+ *  reading them.
+ */
+void ShmFrameDestroy(ShmFrames *shm) {
+  int i;
+
+  if (shm) {
+    XSync(shm->dpy, False);
+    for (i = 0; i < shm->nBuffers; i++) {
+      DestroyBuffer(shm, i);
+    }
+    free(shm);
+  }
+}
+
+/*
+ *  ShmFrameNext - Moves on to the next buffer and returns it for drawing.
+ */
+RasterImage *ShmFrameNext(ShmFrames *shm) {
+  shm->current = (shm->current + 1) % shm->nBuffers;
+
+  return (shm->rasters[shm->current]);
+}
+
+/*
+ *  ShmFramePut - Shows the width x height part of the current buffer at
+ *  x, y in drawable, moved over by dstX, dstY.
+ */
+void ShmFramePut(ShmFrames *shm, Drawable drawable, GC gc, int x, int y,
+                 int width, int height, int dstX, int dstY) {
+  XShmPutImage(shm->dpy, drawable, gc, shm->images[shm->current], x, y,
+               x + dstX, y + dstY, width, height, False);
+}
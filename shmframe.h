@@ -0,0 +1,37 @@
+#ifndef SHMFRAME_H
+#define SHMFRAME_H
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
+
+#include "raster.h"
+
+/*
+ *  Client side compositing into MIT-SHM images.
+ *
+ *  Frames are composed with the software renderer straight into shared
+ *  memory and handed to the server with XShmPutImage, so the server does
+ *  no stippling or plane expansion at all.  Several buffers are cycled so
+ *  a frame still being read by the server is never drawn over; the frame
+ *  fences in present.c guarantee that with buffers = framesInFlight + 1.
+ */
+#define MAX_SHM_BUFFERS 17
+
+typedef struct {
+  Display *dpy;
+  int nBuffers;
+  int current;
+
+  XImage *images[MAX_SHM_BUFFERS];
+  XShmSegmentInfo segments[MAX_SHM_BUFFERS];
+  RasterImage *rasters[MAX_SHM_BUFFERS];
+} ShmFrames;
+
+ShmFrames *ShmFrameCreate(Display *dpy, Visual *visual, int depth, int width,
+                          int height, int buffers);
+void ShmFrameDestroy(ShmFrames *shm);
+RasterImage *ShmFrameNext(ShmFrames *shm);
+void ShmFramePut(ShmFrames *shm, Drawable drawable, GC gc, int x, int y,
+                 int width, int height, int dstX, int dstY);
+
+#endif
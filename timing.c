@@ -0,0 +1,90 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "timing.h"
+
+/*
+ *  TimingNow - Monotonic time in nanoseconds.
+ */
+int64_t TimingNow(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+/*
+ *  TimingSleepUntil - Sleeps until an absolute TimingNow deadline.
+ */
+void TimingSleepUntil(int64_t deadline) {
+  struct timespec ts;
+
+  ts.tv_sec = deadline / 1000000000;
+  ts.tv_nsec = deadline % 1000000000;
+
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    ;
+}
+
+void LatencyInit(LatencyStats *stats, int capacity) {
+  stats->samples = (double *)malloc(capacity * sizeof(double));
+  stats->count = 0;
+  stats->capacity = capacity;
+}
+
+void LatencyAdd(LatencyStats *stats, double ms) {
+  if (stats->count < stats->capacity) {
+    stats->samples[stats->count++] = ms;
+  }
+}
+
+static int CompareDouble(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+
+  return (da < db ? -1 : da > db ? 1 : 0);
+}
+
+/*
+ *  LatencyPercentile - Nearest-rank percentile (0-100) of the samples.
+ *  Sorts the samples in place.
+ */
+double LatencyPercentile(LatencyStats *stats, double percentile) {
+  int rank;
+
+  if (stats->count == 0) {
+    return (0.0);
+  }
+
+  qsort(stats->samples, stats->count, sizeof(double), CompareDouble);
+
+  rank = (int)(percentile / 100.0 * stats->count + 0.5) - 1;
+  rank = rank < 0 ? 0 : rank >= stats->count ? stats->count - 1 : rank;
+
+  return (stats->samples[rank]);
+}
+
+/*
+ *  LatencyReport - One line of throughput and latency percentiles;
+ *  elapsed is the wall time the samples were taken over, in ns.
+ */
+void LatencyReport(FILE *fp, const char *label, LatencyStats *stats,
+                   int64_t elapsed) {
+  double seconds = elapsed / 1e9;
+
+  fprintf(fp,
+          "%-10s %6d frames in %8.3f s  %9.1f fps  "
+          "p50 %7.3f ms  p95 %7.3f ms  p99 %7.3f ms\n",
+          label, stats->count, seconds,
+          seconds > 0.0 ? stats->count / seconds : 0.0,
+          LatencyPercentile(stats, 50.0), LatencyPercentile(stats, 95.0),
+          LatencyPercentile(stats, 99.0));
+}
+
+void LatencyFree(LatencyStats *stats) {
+  free(stats->samples);
+  memset(stats, 0, sizeof(LatencyStats));
+}
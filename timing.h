@@ -0,0 +1,26 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ *  Frame timing helpers.
+ */
+typedef struct {
+  double *samples; /*  Milliseconds            */
+  int count;
+  int capacity;
+} LatencyStats;
+
+int64_t TimingNow(void);
+void TimingSleepUntil(int64_t deadline);
+
+void LatencyInit(LatencyStats *stats, int capacity);
+void LatencyAdd(LatencyStats *stats, double ms);
+double LatencyPercentile(LatencyStats *stats, double percentile);
+void LatencyReport(FILE *fp, const char *label, LatencyStats *stats,
+                   int64_t elapsed);
+void LatencyFree(LatencyStats *stats);
+
+#endif
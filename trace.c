@@ -0,0 +1,120 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+typedef struct {
+  const char *name; /*  Static string           */
+  int64_t start;    /*  Monotonic ns            */
+  int64_t end;
+  int track;
+} TraceEvent;
+
+int traceEnabled = 0;
+
+static TraceEvent *events;
+static long nEvents; /*  Ever recorded; the ring keeps the last ones  */
+static const char *tracePath;
+static XtSignalId dumpSignal;
+
+static void DumpSignal(XtPointer closure, XtSignalId *id) {
+  (void *)closure;
+  (void *)id;
+
+  TraceDump();
+}
+
+/*
+ *  NoticeDump - SIGUSR1 handler.  Only tells Xt; the dump itself runs
+ *  from the event loop, where stdio is safe.
+ */
+static void NoticeDump(int sig) {
+  (void)sig;
+
+  XtNoticeSignal(dumpSignal);
+}
+
+/*
+ *  TraceStart - Starts recording, to be written to path.
+ */
+void TraceStart(XtAppContext app, const char *path) {
+  events = (TraceEvent *)malloc(TRACE_EVENTS * sizeof(TraceEvent));
+  nEvents = 0;
+  tracePath = path;
+  traceEnabled = 1;
+
+  dumpSignal = XtAppAddSignal(app, DumpSignal, NULL);
+  signal(SIGUSR1, NoticeDump);
+  atexit(TraceDump);
+}
+
+void TraceSpan(const char *name, int64_t start, int64_t end, int track) {
+  TraceEvent *event = &events[nEvents++ % TRACE_EVENTS];
+
+  event->name = name;
+  event->start = start;
+  event->end = end;
+  event->track = track;
+}
+
+/*
+ *  TraceDump - Writes what the ring holds, oldest first, over the
+ *  trace file.  Recording goes on.
+ */
+void TraceDump(void) {
+  long first = nEvents > TRACE_EVENTS ? nEvents - TRACE_EVENTS : 0;
+  int maxTrack = 0;
+  int pid = (int)getpid();
+  long i;
+  int track;
+  FILE *fp;
+
+  if (!traceEnabled) {
+    return;
+  }
+
+  fp = fopen(tracePath, "w");
+  if (fp == NULL) {
+    perror(tracePath);
+    return;
+  }
+
+  fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  for (i = first; i < nEvents; i++) {
+    TraceEvent *event = &events[i % TRACE_EVENTS];
+
+    fprintf(fp,
+            "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+            "\"ts\":%.3f,\"dur\":%.3f},\n",
+            event->name, pid, event->track, event->start / 1e3,
+            (event->end - event->start) / 1e3);
+    if (event->track > maxTrack) {
+      maxTrack = event->track;
+    }
+  }
+
+  /*
+   *  Name the tracks; the last entry also ends the list without a comma
+   */
+  for (track = 0; track <= maxTrack; track++) {
+    fprintf(fp,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"name\":\"",
+            pid, track);
+    if (track == TRACE_SCHED) {
+      fprintf(fp, "scheduler");
+    } else {
+      fprintf(fp, "clock %d", track - 1);
+    }
+    fprintf(fp, "\"}}%s\n", track < maxTrack ? "," : "");
+  }
+
+  fprintf(fp, "]}\n");
+  fclose(fp);
+
+  fprintf(stderr, "xclock: wrote %ld trace events to %s\n", nEvents - first,
+          tracePath);
+}
@@ -0,0 +1,41 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#include <X11/Intrinsic.h>
+
+#include "timing.h"
+
+/*
+ *  Frame tracer.
+ *
+ *  Spans of the phases of a frame (the time lookup, hand geometry,
+ *  request generation, waiting on the server, timer lateness) go into a
+ *  ring holding the last TRACE_EVENTS of them.  The ring is written out
+ *  as Chrome trace-event JSON, which chrome://tracing and Perfetto
+ *  load, on SIGUSR1 and at exit.  Each clock is a track (a "thread" in
+ *  the viewer) of its own; track 0 is the scheduler.
+ *
+ *  Until TraceStart is called the macros cost one test of traceEnabled,
+ *  and nothing is allocated.
+ */
+#define TRACE_EVENTS 65536
+
+#define TRACE_SCHED 0 /*  Track of the scheduler  */
+
+extern int traceEnabled;
+
+#define TraceBegin() (traceEnabled ? TimingNow() : 0)
+#define TraceEnd(name, start, track)                                           \
+  do {                                                                         \
+    if (traceEnabled) {                                                        \
+      TraceSpan(name, start, TimingNow(), track);                              \
+    }                                                                          \
+  } while (0)
+
+void TraceStart(XtAppContext app, const char *path);
+void TraceSpan(const char *name, int64_t start, int64_t end, int track);
+void TraceDump(void);
+
+#endif
@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "wallclock.h"
+
+#ifdef CLOCK_REALTIME_COARSE
+#define COARSE_CLOCK CLOCK_REALTIME_COARSE
+#else
+#define COARSE_CLOCK CLOCK_REALTIME
+#endif
+
+#define ZONE_FILE "/etc/localtime"
+
+static long coarseRes = -1; /*  Coarse clock resolution, ns     */
+
+static time_t minuteStart = 1; /*  Cached minute; empty to begin   */
+static time_t minuteEnd = 0;
+static struct tm minuteTm; /*  Broken down at minuteStart      */
+
+static char *zoneEnv; /*  TZ and zone file when last set  */
+static struct stat zoneFile;
+
+/*
+ *  ZoneChanged - Whether TZ or the zone file are not what they were
+ *  when last looked at.  The first call always says they changed.
+ */
+static int ZoneChanged(void) {
+  static int known = 0;
+  const char *env = getenv("TZ");
+  struct stat st;
+  int changed = !known;
+
+  if (stat(ZONE_FILE, &st) != 0) {
+    memset(&st, 0, sizeof(st));
+  }
+  if (st.st_ino != zoneFile.st_ino || st.st_mtime != zoneFile.st_mtime ||
+      st.st_dev != zoneFile.st_dev) {
+    zoneFile = st;
+    changed = 1;
+  }
+  if ((env == NULL) != (zoneEnv == NULL) ||
+      (env != NULL && strcmp(env, zoneEnv) != 0)) {
+    free(zoneEnv);
+    zoneEnv = env != NULL ? strdup(env) : NULL;
+    changed = 1;
+  }
+
+  known = 1;
+  return (changed);
+}
+
+/*
+ *  WallClockNow - The local time, and how far into its second.
+ */
+void WallClockNow(struct tm *tm, long *nsec) {
+  struct timespec now;
+
+  if (coarseRes < 0) {
+    struct timespec res;
+
+    clock_getres(COARSE_CLOCK, &res);
+    coarseRes = res.tv_sec > 0 ? 1000000000 : res.tv_nsec;
+  }
+
+  clock_gettime(COARSE_CLOCK, &now);
+  if (now.tv_nsec + coarseRes >= 1000000000) {
+    clock_gettime(CLOCK_REALTIME, &now);
+  }
+
+  if (now.tv_sec < minuteStart || now.tv_sec >= minuteEnd) {
+    if (ZoneChanged()) {
+      tzset();
+    }
+    localtime_r(&now.tv_sec, &minuteTm);
+    minuteStart = now.tv_sec - minuteTm.tm_sec;
+    minuteEnd = minuteStart + 60;
+    minuteTm.tm_sec = 0;
+  }
+
+  *tm = minuteTm;
+  tm->tm_sec = (int)(now.tv_sec - minuteStart);
+  *nsec = now.tv_nsec;
+}
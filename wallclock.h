@@ -0,0 +1,23 @@
+#ifndef WALLCLOCK_H
+#define WALLCLOCK_H
+
+#include <time.h>
+
+/*
+ *  Wall clock.
+ *
+ *  Local time, broken down, for every frame without a libc time
+ *  conversion per frame.  The broken-down start of the current minute
+ *  is kept, and the seconds are added to it arithmetically; localtime
+ *  only runs again once the clock leaves that minute, which is also as
+ *  often as a UTC offset can change.  Before it does, TZ and the zone
+ *  file are checked, and tzset is called if either changed, so zone and
+ *  DST changes are picked up by the next minute at the latest.
+ *
+ *  The time is read from the coarse realtime clock, except close to a
+ *  second boundary, where the coarse clock could still be on the last
+ *  second.
+ */
+void WallClockNow(struct tm *tm, long *nsec);
+
+#endif
@@ -1,5 +1,7 @@
 #include <X11/ICE/ICElib.h>
 #include <X11/X.h>
+#include <errno.h>
+#include <limits.h>
 #include <math.h>
 #include <pwd.h>
 #include <stdio.h>
@@ -35,52 +37,96 @@
 #include "graphics/bitmaps.h"
 
 /*
- *  Cat body part pixmaps
+ *  Software renderer
  */
-static Pixmap *eyePixmap = (Pixmap *)NULL;  /*  Array of eyes     */
-static Pixmap *tailPixmap = (Pixmap *)NULL; /*  Array of tails    */
+#include "atlas.h"
+#include "blank.h"
+#include "budget.h"
+#include "catrender.h"
+#include "colorize.h"
+#include "control.h"
+#include "export.h"
+#include "frames.h"
+#include "governor.h"
+#include "present.h"
+#include "raster.h"
+#include "renderahead.h"
+#include "sched.h"
+#include "sharecache.h"
+#include "shmframe.h"
+#include "timing.h"
+#include "trace.h"
+#include "wallclock.h"
 
 /*
- *  Cat GC's
+ *  The pendulum swings from frame 0
  */
-static GC catGC;  /*  For drawing cat's body    */
-static GC tailGC; /*  For drawing cat's tail    */
-static GC eyeGC;  /*  For drawing cat's eyes    */
+static int64_t swingEpoch; /*  Monotonic time of frame 0          */
 
 /*
- *  Default cat dimension stuff -- don't change sizes!!!!
+ *  Quality levels the governor chooses between, cheapest first.  The
+ *  client side frames of each, one set per scale, come from the frame
+ *  cache and are shared by every clock; each clock has its own
+ *  atlases.  Both are only made once first used.
  */
-#define DEF_N_TAILS 40     /*  Default resolution        */
-#define TAIL_HEIGHT 89     /*  Tail pixmap height        */
-#define DEF_CAT_WIDTH 150  /*  Cat body pixmap width     */
-#define DEF_CAT_HEIGHT 300 /*  Cat body pixmap height    */
-#define DEF_CAT_BOTTOM 210 /*  Distance to cat's butt    */
+typedef struct {
+  int nTails;
+} CatLevel;
+
+#define N_LEVELS 4
+#define DEF_LEVEL (N_LEVELS - 1) /*  The configured nTails, the most  */
+                                 /*  the governor climbs back to; the */
+                                 /*  others halve it in turn.         */
+
+static CatLevel levels[N_LEVELS];
+
+/*
+ *  Caps the level of every clock, and stretches the frame period, to
+ *  keep what they all send under the bandwidth resource
+ */
+static Budget budget;
+
+#define MAX_N_TAILS 1000 /*  Most a running clock can be set to  */
+#define MAX_N_TAILS_STRING "1000"
+#define MAX_FPS 1000 /*  Most frames a second the control socket sets  */
+#define MAX_FPS_STRING "1000"
+
+static Bool loadingIdle = False; /*  LoadFramesIdle queued   */
+
+static int shareTails; /*  Default level's nTails at startup  */
+
+/*
+ *  Render-ahead worker, if renderAhead is set.  Its lock guards the
+ *  levels and each clock's frames, level, layout and hands.
+ */
+static RenderAhead *ahead = (RenderAhead *)NULL;
 
 /*
- *  Clock hand stuff
+ *  Visibility: the cat is only animated while it can be seen
  */
-#define VERTICES_IN_HANDS 4  /*  Hands are triangles      */
-#define SECOND_HAND_FRACT 90 /*  Percentages of radius    */
-#define MINUTE_HAND_FRACT 70
-#define HOUR_HAND_FRACT 40
-#define HAND_WIDTH_FRACT 7
-#define SECOND_WIDTH_FRACT 5
+static Bool paused = False; /*  No clock visible, ticking once a minute */
+static Bool held = False;   /*  Paused from the control socket          */
 
-static int centerX = 0; /*  Window coord origin of      */
-static int centerY = 0; /*  clock hands.                */
+#define PAUSED_PERIOD ((int64_t)60 * 1000000000)
 
-static int radius; /*  Radius of clock face        */
+/*
+ *  The cat is scaled to fit its window, in steps of 1/SCALE_STEPS of
+ *  its natural size, so that every size in a step shares one set of
+ *  frames.  Natural size suits DEF_DPI.
+ */
+#define SCALE_STEPS 4
+#define DEF_DPI 96.0
 
-static int secondHandLength; /*  Current lengths and widths  */
-static int minuteHandLength;
-static int hourHandLength;
-static int handWidth;
-static int secondHandWidth;
+/*
+ *  How the tail and eyes are put on screen, unless copyMode says: the
+ *  1-bit frames are CopyPlaned through a GC that colors them, or
+ *  frames colored at the window's depth once are CopyAreaed.  Which is
+ *  faster depends on the server, so both are timed on
+ *  COPY_PROBE_FRAMES copies at startup.
+ */
+#define COPY_PROBE_FRAMES 100
 
-#define SEG_BUFF_SIZE 128                  /*  Max buffer size     */
-static int numSegs = 0;                    /*  Segments in buffer  */
-static XPoint segBuf[SEG_BUFF_SIZE];       /*  Buffer              */
-static XPoint *segBufPtr = (XPoint *)NULL; /*  Current pointer     */
+#define SEG_BUFF_SIZE 128 /*  Max buffer size     */
 
 /*
  *  Default font for digital display
@@ -96,25 +142,19 @@ static XPoint *segBufPtr = (XPoint *)NULL; /*  Current pointer     */
 /*
  *  Time stuff
  */
-static struct tm tm;  /*  What time is it?            */
-static struct tm otm; /*  What time was it?           */
+static struct tm tm;   /*  What time is it?            */
+static long tmNsec;    /*  And how far into its second */
+static int64_t tmRead; /*  Monotonic time it was read  */
+
+static int secondHand = SECONDS_NONE; /*  Second hand style  */
 
 /*
  *  X11 Stuff
  */
-static Window clockWindow = (Window)NULL;
 static XtAppContext appContext;
-Display *dpy;
-Window root;
-int screen;
-
-GC gc;             /*  For tick-marks, text, etc.  */
-static GC handGC;  /*  For drawing hands           */
-static GC eraseGC; /*  For erasing hands           */
-static GC highGC;  /*  For hand borders            */
 
 /*
- *  Resources user can set in addition to normal Xt resources
+ *  Read once for appData, then again for each clock's display
  */
 typedef struct {
   XFontStruct *font; /*  For alarm & analog  */
@@ -133,16 +173,122 @@ typedef struct {
   int padding;      /*  Font spacing        */
   char *modeString; /*  Display mode        */
 
-  int update;    /*  Seconds between     */
-                 /*  updates             */
+  int fps;       /*  Frames per second,  */
+                 /*  0 = one per tail    */
+  int bandwidth; /*  Bytes a second to   */
+                 /*  send, 0 = no limit  */
   Boolean chime; /*  Chime on hour?      */
 
   int help; /*  Display syntax      */
 
+  int framesInFlight; /*  Unsynced frames     */
+  Boolean shm;        /*  Compose client side */
+  Boolean governor;   /*  Adapt to the server */
+  Boolean share;      /*  Use pixmaps other   */
+                      /*  catclocks publish   */
+  Boolean renderAhead; /*  Plan frames on a    */
+                       /*  thread of their own */
+  char *trace;        /*  Trace file, if any  */
+  char *control;      /*  Control socket path */
+  char *copyMode;     /*  plane, area or auto */
+  float scale;        /*  Cat size, 0 = from  */
+                      /*  the screen's DPI    */
+  char *seconds;      /*  none, tick or sweep */
+
+  char *displays;     /*  More displays       */
+  Boolean allScreens; /*  Every screen of     */
+                      /*  every display       */
+
+  int benchmark;     /*  Frames to benchmark */
+  int benchmarkRate; /*  Benchmark pacing,   */
+                     /*  frames per second   */
+
 } ApplicationData, *ApplicationDataPtr;
 
 static ApplicationData appData;
 
+/*
+ *  One clock window.  The process shows one on every screen it was
+ *  asked for, all on the same app context and event loop; the client
+ *  side frames and time are shared by all of them.
+ */
+typedef struct {
+  Display *dpy;
+  int screen;
+  Window root;
+  Widget topLevel;
+  Widget canvas;
+  Window window;
+  Bool bell; /*  First clock on its display  */
+  int width; /*  Window size                 */
+  int height;
+
+  CatLayout layout;  /*  Cat's scale and place       */
+  double shareScale; /*  Scale it started at         */
+  CatHands hands;    /*  Hand geometry, window coords */
+  Pixmap catTile;    /*  Body, at layout's scale     */
+  Bool tileShared;   /*  catTile is in frame cache   */
+
+  ApplicationData res; /*  Colors, for this display    */
+
+  GC gc;      /*  For tick-marks, text, etc.  */
+  GC handGC;  /*  For drawing hands           */
+  GC eraseGC; /*  For erasing hands           */
+  GC highGC;  /*  For hand borders            */
+  GC catGC;   /*  For drawing cat's body      */
+  GC tailGC;  /*  For drawing cat's tail      */
+  GC eyeGC;   /*  For drawing cat's eyes      */
+  Bool tailClipped;
+  Bool eyeClipped;
+
+  /*
+   *  Cat body part pixmaps, one atlas per animation and level
+   */
+  FrameAtlas *tailAtlas[N_LEVELS];
+  FrameAtlas *eyeAtlas[N_LEVELS];
+  Bool colorFrames; /*  Atlases at window depth     */
+  int level;       /*  Current entry in levels     */
+  FrameSet *frames; /*  Its frames at layout's scale */
+  Governor governor;
+  int shownTail; /*  Frame now on screen, -1 if none  */
+
+  int numSegs;                  /*  Segments in buffer  */
+  XPoint segBuf[SEG_BUFF_SIZE]; /*  Buffer              */
+  XPoint *segBufPtr;            /*  Current pointer     */
+  struct tm otm;                /*  Time the hands show */
+
+  /*
+   *  The second hand is taken off the window by copying back the box
+   *  it covered from secondFace, which holds what is under the circle
+   *  it goes round: the body and the minute and hour hands.
+   */
+  Pixmap secondFace;
+  XRectangle faceBox; /*  secondFace's place in the window  */
+  XPoint secondPts[SECOND_HAND_PTS];
+  Bool secondShown; /*  secondPts are on screen          */
+
+  Region damage; /*  Exposed, not yet repainted  */
+
+  Presenter *present;
+
+  /*
+   *  Client side compositing (MIT-SHM), if shm is not NULL
+   */
+  ShmFrames *shm;
+  RasterImage *bodyImage;
+  CatColors catColors;
+
+  Bool mapped;   /*  Shell is mapped             */
+  Bool obscured; /*  Canvas is fully covered     */
+  Bool blanked;  /*  Screen saver or DPMS is on  */
+} Clock;
+
+static Clock *clocks = (Clock *)NULL;
+static int nClocks = 0;
+
+#define ClockTrack(c) ((int)((c)-clocks) + 1) /*  Its trace track  */
+#define ClockHidden(c) (!(c)->mapped || (c)->obscured || (c)->blanked)
+
 /*
  *  Miscellaneous stuff
  */
@@ -153,15 +299,15 @@ static ApplicationData appData;
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #define max(a, b) ((a) > (b) ? (a) : (b))
 
-GC CreateTailGC(void) {
+GC CreateTailGC(Clock *c) {
   GC tailGC;
   XGCValues tailGCV;
   unsigned long valueMask;
 
   tailGCV.function = GXcopy;
   tailGCV.plane_mask = AllPlanes;
-  tailGCV.foreground = appData.catColor;
-  tailGCV.background = appData.background;
+  tailGCV.foreground = c->res.catColor;
+  tailGCV.background = c->res.background;
   tailGCV.line_width = 15;
   tailGCV.line_style = LineSolid;
   tailGCV.cap_style = CapRound;
@@ -178,20 +324,20 @@ GC CreateTailGC(void) {
               GCFillStyle | GCSubwindowMode | GCClipXOrigin | GCClipYOrigin |
               GCClipMask | GCGraphicsExposures;
 
-  tailGC = XCreateGC(dpy, clockWindow, valueMask, &tailGCV);
+  tailGC = XCreateGC(c->dpy, c->window, valueMask, &tailGCV);
 
   return (tailGC);
 }
 
-static GC CreateEyeGC(void) {
+static GC CreateEyeGC(Clock *c) {
   GC eyeGC;
   XGCValues eyeGCV;
   unsigned long valueMask;
 
   eyeGCV.function = GXcopy;
   eyeGCV.plane_mask = AllPlanes;
-  eyeGCV.foreground = appData.catColor;
-  eyeGCV.background = appData.detailColor;
+  eyeGCV.foreground = c->res.catColor;
+  eyeGCV.background = c->res.detailColor;
   eyeGCV.line_width = 15;
   eyeGCV.line_style = LineSolid;
   eyeGCV.cap_style = CapRound;
@@ -208,109 +354,17 @@ static GC CreateEyeGC(void) {
               GCFillStyle | GCSubwindowMode | GCClipXOrigin | GCClipYOrigin |
               GCClipMask | GCGraphicsExposures;
 
-  eyeGC = XCreateGC(dpy, clockWindow, valueMask, &eyeGCV);
+  eyeGC = XCreateGC(c->dpy, c->window, valueMask, &eyeGCV);
 
   return (eyeGC);
 }
 
-Pixmap CreateTailPixmap(double t) {
-  Pixmap tailBitmap;
-  GC bitmapGC;
-  double sinTheta, cosTheta; /*  Pendulum parameters */
-  double A = 0.4;
-  double omega = 1.0;
-  double phi = 3 * M_PI_2;
-  double angle;
-
-  static XPoint tailOffset = {74, -15};
-
-#define N_TAIL_PTS 7
-  static XPoint tail[N_TAIL_PTS] = {
-      /*  "Center" tail definition */
-      {0, 0}, {0, 76}, {3, 82}, {10, 84}, {18, 82}, {21, 76}, {21, 70},
-  };
-
-  XPoint offCenterTail[N_TAIL_PTS]; /* off center tail    */
-  XPoint newTail[N_TAIL_PTS];       /*  Tail at time "t"  */
-  XGCValues bitmapGCV;              /*  GC for drawing    */
-  unsigned long valueMask;
-  int i;
-
-  /*
-   *  Create GC for drawing tail
-   */
-  bitmapGCV.function = GXcopy;
-  bitmapGCV.plane_mask = AllPlanes;
-  bitmapGCV.foreground = 1;
-  bitmapGCV.background = 0;
-  bitmapGCV.line_width = 15;
-  bitmapGCV.line_style = LineSolid;
-  bitmapGCV.cap_style = CapRound;
-  bitmapGCV.join_style = JoinRound;
-  bitmapGCV.fill_style = FillSolid;
-  bitmapGCV.subwindow_mode = ClipByChildren;
-  bitmapGCV.clip_x_origin = 0;
-  bitmapGCV.clip_y_origin = 0;
-  bitmapGCV.clip_mask = None;
-
-  valueMask = GCFunction | GCPlaneMask | GCForeground | GCBackground |
-              GCLineWidth | GCLineStyle | GCCapStyle | GCJoinStyle |
-              GCFillStyle | GCSubwindowMode | GCClipXOrigin | GCClipYOrigin |
-              GCClipMask;
-
-  tailBitmap =
-      XCreateBitmapFromData(dpy, root, tail_bits, tail_width, tail_height);
-  bitmapGC = XCreateGC(dpy, tailBitmap, valueMask, &bitmapGCV);
-
-  {
-    /*
-     *  Create an "off-center" tail to deal with the fact that
-     *  the tail has a hook to it.  A real pendulum so shaped would
-     *  hang a bit to the left (as you look at the cat).
-     */
-    angle = -0.08;
-    sinTheta = sin(angle);
-    cosTheta = cos(angle);
-
-    for (i = 0; i < N_TAIL_PTS; i++) {
-      offCenterTail[i].x = (int)((double)(tail[i].x) * cosTheta +
-                                 (double)(tail[i].y) * sinTheta);
-      offCenterTail[i].y = (int)((double)(-tail[i].x) * sinTheta +
-                                 (double)(tail[i].y) * cosTheta);
-    }
-  }
-
-  /*
-   *  Compute pendulum function.
-   */
-  angle = A * sin(omega * t + phi);
-  sinTheta = sin(angle);
-  cosTheta = cos(angle);
-
-  /*
-   *  Rotate the center tail about its origin by "angle" degrees.
-   */
-  for (i = 0; i < N_TAIL_PTS; i++) {
-    newTail[i].x = (int)((double)(offCenterTail[i].x) * cosTheta +
-                         (double)(offCenterTail[i].y) * sinTheta);
-    newTail[i].y = (int)((double)(-offCenterTail[i].x) * sinTheta +
-                         (double)(offCenterTail[i].y) * cosTheta);
-
-    newTail[i].x += tailOffset.x;
-    newTail[i].y += tailOffset.y;
-  }
-
-  /*
-   *  Create pixmap for drawing tail (and stippling on update)
-   */
-  XDrawLines(dpy, tailBitmap, bitmapGC, newTail, N_TAIL_PTS, CoordModeOrigin);
-
-  XFreeGC(dpy, bitmapGC);
-
-  return (tailBitmap);
-}
-
-void ParseGeometry(Widget topLevel) {
+/*
+ *  ParseGeometry - Sizes topLevel from the geometry resource.  Any
+ *  size goes; if none is given the cat starts out scale times its
+ *  natural size.
+ */
+void ParseGeometry(Widget topLevel, double scale) {
   int n;
   Arg args[10];
   char *geomString = NULL;
@@ -337,7 +391,8 @@ void ParseGeometry(Widget topLevel) {
      *  User didn't specify any geometry, so we
      *  use the default.
      */
-    sprintf(geometry, "%dx%d", DEF_CAT_WIDTH, DEF_CAT_HEIGHT);
+    sprintf(geometry, "%dx%d", CatScaled(DEF_CAT_WIDTH, scale),
+            CatScaled(DEF_CAT_HEIGHT, scale));
   } else {
     /*
      *  Gotta do some work.
@@ -352,10 +407,14 @@ void ParseGeometry(Widget topLevel) {
     geomMask = XParseGeometry(geomString, &x, &y, &width, &height);
 
     /*
-     *  Fix the cat width and height
+     *  Use the width and height, or the default ones
      */
-    sprintf(widthString, "%d", DEF_CAT_WIDTH);
-    sprintf(heightString, "x%d", DEF_CAT_HEIGHT);
+    sprintf(widthString, "%d",
+            geomMask & WidthValue ? (int)width
+                                  : CatScaled(DEF_CAT_WIDTH, scale));
+    sprintf(heightString, "x%d",
+            geomMask & HeightValue ? (int)height
+                                   : CatScaled(DEF_CAT_HEIGHT, scale));
 
     /*
      *  Use the x and y values, if any
@@ -391,42 +450,31 @@ void ParseGeometry(Widget topLevel) {
   }
 
   /*
-   *  Stash the width and height in some globals (ugh!)
+   *  Set the geometry of the topLevel widget
    */
   {
-    int ww = DEF_CAT_WIDTH;
-    int hh = DEF_CAT_HEIGHT;
+    int ww = CatScaled(DEF_CAT_WIDTH, scale);
+    int hh = CatScaled(DEF_CAT_HEIGHT, scale);
     sscanf(geometry, "%dx%d", &ww, &hh);
-  }
 
-  /*
-   *  Set the geometry of the topLevel widget
-   */
-  n = 0;
-  XtSetArg(args[n], XmNwidth, DEF_CAT_WIDTH);
-  n++;
-  XtSetArg(args[n], XmNheight, DEF_CAT_HEIGHT);
-  n++;
-  XtSetArg(args[n], XmNminWidth, DEF_CAT_WIDTH);
-  n++;
-  XtSetArg(args[n], XmNminHeight, DEF_CAT_HEIGHT);
-  n++;
-  XtSetArg(args[n], XmNmaxWidth, DEF_CAT_WIDTH);
-  n++;
-  XtSetArg(args[n], XmNmaxHeight, DEF_CAT_HEIGHT);
-  n++;
+    n = 0;
+    XtSetArg(args[n], XmNwidth, ww);
+    n++;
+    XtSetArg(args[n], XmNheight, hh);
+    n++;
+  }
   XtSetArg(args[n], XmNgeometry, geometry);
   n++;
   XtSetValues(topLevel, args, n);
 }
 
-void SetSeg(int x1, int y1, int x2, int y2) {
-  segBufPtr->x = x1;
-  segBufPtr++->y = y1;
-  segBufPtr->x = x2;
-  segBufPtr++->y = y2;
+void SetSeg(Clock *c, int x1, int y1, int x2, int y2) {
+  c->segBufPtr->x = x1;
+  c->segBufPtr++->y = y1;
+  c->segBufPtr->x = x2;
+  c->segBufPtr++->y = y2;
 
-  numSegs += 2;
+  c->numSegs += 2;
 }
 
 /*
@@ -442,7 +490,8 @@ void SetSeg(int x1, int y1, int x2, int y2) {
  *  to the perimeter, then erasing all but the outside most pixels doesn't
  *  work because of round-off error (sigh).
  */
-void DrawLine(int blankLength, int length, double fractionOfACircle) {
+void DrawLine(Clock *c, int blankLength, int length,
+              double fractionOfACircle) {
   double angle, cosAngle, sinAngle;
 
   /*
@@ -458,416 +507,918 @@ void DrawLine(int blankLength, int length, double fractionOfACircle) {
   cosAngle = cos(angle);
   sinAngle = sin(angle);
 
-  SetSeg(centerX + (int)(blankLength * sinAngle),
-         centerY - (int)(blankLength * cosAngle),
-         centerX + (int)(length * sinAngle),
-         centerY - (int)(length * cosAngle));
+  SetSeg(c, c->hands.centerX + (int)(blankLength * sinAngle),
+         c->hands.centerY - (int)(blankLength * cosAngle),
+         c->hands.centerX + (int)(length * sinAngle),
+         c->hands.centerY - (int)(length * cosAngle));
 }
 
-int Round(double x) { return (x >= 0.0 ? (int)(x + 0.5) : (int)(x - 0.5)); }
-
 /*
- *  DrawHand - Draws a hand.
- *
- *  length is the maximum length of the hand.
- *  width is the half-width of the hand.
- *  fractionOfACircle is a fraction between 0 and 1 (inclusive) indicating
- *  how far around the circle (clockwise) from high noon.
- *
+ *  SaveSecondFace - Paints secondFace with what the window shows under
+ *  the second hand's circle, from the body tile and the minute and hour
+ *  hands in segBuf.  The window itself is never read back: whatever
+ *  covers it would be saved too.  The circle is clear of the tail and
+ *  eyes at every scale.
  */
-void DrawHand(int length, int width, double fractionOfACircle) {
-  double angle, cosAngle, sinAngle;
-  double ws, wc;
-  int x, y, x1, y1, x2, y2;
-
-  /*
-   *  A full circle is 2 PI radians.
-   *  Angles are measured from 12 o'clock, clockwise increasing.
-   *  Since in X, +x is to the right and +y is downward:
-   *
-   *    x = x0 + r * sin(theta)
-   *    y = y0 - r * cos(theta)
-   *
-   */
-  angle = TWOPI * fractionOfACircle;
-  cosAngle = cos(angle);
-  sinAngle = sin(angle);
+void SaveSecondFace(Clock *c) {
+  CatLayout *l = &c->layout;
+  int reach = c->hands.secondHandLength + c->hands.secondHandWidth + 1;
+  int size = 2 * reach + 1;
+  XPoint pts[VERTICES_IN_HANDS + 2];
+  int hand, i;
+
+  if (c->secondFace == None || c->faceBox.width != size) {
+    if (c->secondFace != None) {
+      XFreePixmap(c->dpy, c->secondFace);
+    }
+    c->secondFace = XCreatePixmap(c->dpy, c->window, size, size,
+                                  DefaultDepth(c->dpy, c->screen));
+  }
+  c->faceBox.x = c->hands.centerX - reach;
+  c->faceBox.y = c->hands.centerY - reach;
+  c->faceBox.width = c->faceBox.height = size;
+
+  XFillRectangle(c->dpy, c->secondFace, c->eraseGC, 0, 0, size, size);
+  XSetTSOrigin(c->dpy, c->catGC, l->x - c->faceBox.x, l->y - c->faceBox.y);
+  XFillRectangle(c->dpy, c->secondFace, c->catGC, l->x - c->faceBox.x,
+                 l->y - c->faceBox.y, l->width, l->height);
+  XSetTSOrigin(c->dpy, c->catGC, l->x, l->y);
+
+  for (hand = 0; hand < 2; hand++) {
+    for (i = 0; i < VERTICES_IN_HANDS + 2; i++) {
+      pts[i].x = c->segBuf[hand * (VERTICES_IN_HANDS + 2) + i].x -
+                 c->faceBox.x;
+      pts[i].y = c->segBuf[hand * (VERTICES_IN_HANDS + 2) + i].y -
+                 c->faceBox.y;
+    }
+    if (c->res.handColor != c->res.background) {
+      XFillPolygon(c->dpy, c->secondFace, c->handGC, pts,
+                   VERTICES_IN_HANDS + 2, Convex, CoordModeOrigin);
+    }
+    XDrawLines(c->dpy, c->secondFace, c->highGC, pts, VERTICES_IN_HANDS + 2,
+               CoordModeOrigin);
+  }
 
-  /*
-   * Order of points when drawing the hand.
-   *
-   *        1,4
-   *        / \
-   *       /   \
-   *      /     \
-   *    2 ------- 3
-   */
-  wc = width * cosAngle;
-  ws = width * sinAngle;
-  SetSeg(x = centerX + Round(length * sinAngle),
-         y = centerY - Round(length * cosAngle), x1 = centerX - Round(ws + wc),
-         y1 = centerY + Round(wc - ws)); /* 1 ---- 2 */
-  /* 2 */
-  SetSeg(x1, y1, x2 = centerX - Round(ws - wc),
-         y2 = centerY + Round(wc + ws)); /* 2 ----- 3 */
-
-  SetSeg(x2, y2, x, y); /* 3 ----- 1(4) */
+  c->secondShown = False;
 }
 
 /*
- *  DrawSecond - Draws the second hand (diamond).
- *
- *  length is the maximum length of the hand.
- *  width is the half-width of the hand.
- *  offset is direct distance from Center to tail end.
- *  fractionOfACircle is a fraction between 0 and 1 (inclusive) indicating
- *  how far around the circle (clockwise) from high noon.
+ *  DrawSecond - Draws the second hand (diamond), pts from
+ *  CatSecondPoints.
  *
+ *  Only the box the hand covered before is repainted, from secondFace,
+ *  so moving it costs about what a tail frame does.
  */
-void DrawSecond(int length, int width, int offset, int fractionOfACircle) {
-  double angle, cosAngle, sinAngle;
-  double ms, mc, ws, wc;
-  int mid;
-  int x, y;
+void DrawSecond(Clock *c, const XPoint *pts) {
+  XRectangle box;
+  int64_t traceStart;
 
-  /*
-   *  A full circle is 2 PI radians.
-   *  Angles are measured from 12 o'clock, clockwise increasing.
-   *  Since in X, +x is to the right and +y is downward:
-   *
-   *    x = x0 + r * sin(theta)
-   *    y = y0 - r * cos(theta)
-   *
-   */
-  angle = TWOPI * fractionOfACircle;
-  cosAngle = cos(angle);
-  sinAngle = sin(angle);
+  if (c->secondShown &&
+      memcmp(pts, c->secondPts, sizeof(c->secondPts)) == 0) {
+    return;
+  }
+  traceStart = TraceBegin();
 
-  /*
-   * Order of points when drawing the hand.
-   *
-   *        1,5
-   *        / \
-   *       /   \
-   *      /     \
-   *    2<       >4
-   *      \     /
-   *       \   /
-   *        \ /
-   *    -    3
-   *    |
-   *    |
-   *   offset
-   *    |
-   *    |
-   *    -     + center
-   */
-  mid = (length + offset) / 2;
-  mc = mid * cosAngle;
-  ms = mid * sinAngle;
-  wc = width * cosAngle;
-  ws = width * sinAngle;
-  /*1 ---- 2 */
-  SetSeg(x = centerX + Round(length * sinAngle),
-         y = centerY - Round(length * cosAngle), centerX + Round(ms - wc),
-         centerY - Round(mc + ws));
-  SetSeg(centerX + Round(ms - wc), centerY - Round(mc + ws),
-         centerX + Round(offset * sinAngle),
-         centerY - Round(offset * cosAngle)); /* 2-----3 */
-
-  SetSeg(centerX + Round(offset * sinAngle),
-         centerY - Round(offset * cosAngle), /* 3-----4 */
-         centerX + Round(ms + wc), centerY - Round(mc - ws));
-
-  segBufPtr->x = x;
-  segBufPtr++->y = y;
-  numSegs++;
+  if (c->secondShown) {
+    CatPointsBox(c->secondPts, SECOND_HAND_PTS, &box);
+    XCopyArea(c->dpy, c->secondFace, c->window, c->gc, box.x - c->faceBox.x,
+              box.y - c->faceBox.y, box.width, box.height, box.x, box.y);
+  }
+
+  memcpy(c->secondPts, pts, sizeof(c->secondPts));
+  c->secondShown = True;
+
+  if (c->res.handColor != c->res.background) {
+    XFillPolygon(c->dpy, c->window, c->handGC, c->secondPts, SECOND_HAND_PTS,
+                 Convex, CoordModeOrigin);
+  }
+  XDrawLines(c->dpy, c->window, c->highGC, c->secondPts, SECOND_HAND_PTS,
+             CoordModeOrigin);
+
+  TraceEnd("DrawSecond", traceStart, ClockTrack(c));
 }
 
 /*
- *  Draw the clock face (every fifth tick-mark is longer
- *  than the others).
+ *  FillMargins - Fills the window around the cat with the background.
  */
-void DrawClockFace(void) {
-  segBufPtr = segBuf;
-  numSegs = 0;
-  XFillRectangle(dpy, clockWindow, catGC, 0, 0, DEF_CAT_WIDTH, DEF_CAT_HEIGHT);
+void FillMargins(Clock *c) {
+  CatLayout *l = &c->layout;
+  XRectangle around[4];
+  int right = l->x + l->width;
+  int bottom = l->y + l->height;
+
+  around[0].x = around[1].x = 0;
+  around[0].y = 0;
+  around[0].width = around[1].width = c->width;
+  around[0].height = max(l->y, 0);
+  around[1].y = bottom;
+  around[1].height = max(c->height - bottom, 0);
+  around[2].x = 0;
+  around[2].y = around[3].y = l->y;
+  around[2].width = max(l->x, 0);
+  around[2].height = around[3].height = l->height;
+  around[3].x = right;
+  around[3].width = max(c->width - right, 0);
+  XFillRectangles(c->dpy, c->window, c->eraseGC, around, 4);
 }
 
-Pixmap CreateEyePixmap(double t) {
-  Pixmap eyeBitmap;
-  GC bitmapGC;
-
-  double A = 0.7;
-  double omega = 1.0;
-  double phi = 3 * M_PI_2;
-  double angle;
-
-  double u, w;      /*  Sphere parameters    */
-  float r;          /*  Radius               */
-  float x0, y0, z0; /*  Center of sphere     */
+/*
+ *  Draw the clock face (every fifth tick-mark is longer
+ *  than the others), and the background around it.
+ */
+void DrawClockFace(Clock *c) {
+  CatLayout *l = &c->layout;
+  int64_t traceStart = TraceBegin();
 
-  XPoint pts[100];
+  c->segBufPtr = c->segBuf;
+  c->numSegs = 0;
 
-  XGCValues bitmapGCV; /*  GC for drawing       */
-  unsigned long valueMask;
-  int i, j;
+  FillMargins(c);
 
-  typedef struct {
-    double x, y, z;
-  } Point3D;
+  XFillRectangle(c->dpy, c->window, c->catGC, l->x, l->y, l->width,
+                 l->height);
 
   /*
-   *  Create GC for drawing eyes
+   *  That painted over the tail, eyes and second hand too
    */
-  bitmapGCV.function = GXcopy;
-  bitmapGCV.plane_mask = AllPlanes;
-  bitmapGCV.foreground = 1;
-  bitmapGCV.background = 0;
-  bitmapGCV.line_width = 15;
-  bitmapGCV.line_style = LineSolid;
-  bitmapGCV.cap_style = CapRound;
-  bitmapGCV.join_style = JoinRound;
-  bitmapGCV.fill_style = FillSolid;
-  bitmapGCV.subwindow_mode = ClipByChildren;
-  bitmapGCV.clip_x_origin = 0;
-  bitmapGCV.clip_y_origin = 0;
-  bitmapGCV.clip_mask = None;
+  c->shownTail = -1;
+  c->secondShown = False;
 
-  valueMask = GCFunction | GCPlaneMask | GCForeground | GCBackground |
-              GCLineWidth | GCLineStyle | GCCapStyle | GCJoinStyle |
-              GCFillStyle | GCSubwindowMode | GCClipXOrigin | GCClipYOrigin |
-              GCClipMask;
+  TraceEnd("DrawClockFace", traceStart, ClockTrack(c));
+}
 
-  eyeBitmap =
-      XCreateBitmapFromData(dpy, root, eyes_bits, eyes_width, eyes_height);
-  bitmapGC = XCreateGC(dpy, eyeBitmap, valueMask, &bitmapGCV);
+/*
+ *  LoadFrame - Makes sure frame i of c's current level is ready to be
+ *  shown.  Composing client side only needs it rendered.
+ */
+void LoadFrame(Clock *c, int i) {
+  if (c->shm != NULL) {
+    FrameSetRender(c->frames, i);
+  } else if (!AtlasLoaded(c->tailAtlas[c->level], i)) {
+    AtlasPut(c->dpy, c->tailAtlas[c->level], i, FrameSetTail(c->frames, i));
+    AtlasPut(c->dpy, c->eyeAtlas[c->level], i, FrameSetEyes(c->frames, i));
+  }
+}
 
-  /*
-   *  Compute pendulum function.
-   */
-  w = M_PI / 2.0;
+/*
+ *  LoadFramesIdle - Work procedure that loads one more frame of some
+ *  clock's current level, and its delta from the one before, each time
+ *  the client is idle.
+ */
+Boolean LoadFramesIdle(XtPointer closure) {
+  int i, j;
 
-  angle = A * sin(omega * t + phi) + w;
+  (void *)closure;
+
+  RenderAheadLock(ahead);
+  for (j = 0; j < nClocks; j++) {
+    Clock *c = &clocks[j];
+
+    for (i = 0; i <= c->frames->nTails; i++) {
+      if (c->shm != NULL ? c->frames->tails[i] == NULL
+                         : !AtlasLoaded(c->tailAtlas[c->level], i)) {
+        LoadFrame(c, i);
+        if (i > 0) {
+          FrameSetTailDelta(c->frames, i - 1, i);
+        }
+        RenderAheadUnlock(ahead);
+        return (False);
+      }
+    }
+  }
+  RenderAheadUnlock(ahead);
 
-  x0 = 0.0;
-  y0 = 0.0;
-  z0 = 2.0;
-  r = 1.0;
+  loadingIdle = False;
 
-  for (i = 0, u = -M_PI / 2.0; u < M_PI / 2.0; i++, u += 0.25) {
-    Point3D pt;
+  return (True);
+}
 
-    pt.x = x0 + r * cos(u) * cos(angle + M_PI / 7.0);
-    pt.z = z0 + r * cos(u) * sin(angle + M_PI / 7.0);
-    pt.y = y0 + r * sin(u);
+/*
+ *  CreateFrameAtlas - An empty atlas on dpy for nFrames of c's tail or
+ *  eyes, at c's scale: 1-bit, or colored the way tailGC and eyeGC would
+ *  color them if c->colorFrames.
+ */
+FrameAtlas *CreateFrameAtlas(Clock *c, Display *dpy, Bool eyes,
+                             int nFrames) {
+  int width = eyes ? c->layout.eyesWidth : c->layout.width;
+  int height = eyes ? c->layout.eyesHeight : c->layout.tailHeight;
 
-    pts[i].x = (int)(((pt.z == 0.0 ? pt.x : pt.x / pt.z) * 23.0) + 12.0);
-    pts[i].y = (int)(((pt.z == 0.0 ? pt.y : pt.y / pt.z) * 23.0) + 11.0);
+  if (!c->colorFrames) {
+    return (AtlasCreate(dpy, c->root, width, height, nFrames));
   }
 
-  for (u = M_PI / 2.0; u > -M_PI / 2.0; i++, u -= 0.25) {
-    Point3D pt;
-
-    pt.x = x0 + r * cos(u) * cos(angle - M_PI / 7.0);
-    pt.z = z0 + r * cos(u) * sin(angle - M_PI / 7.0);
-    pt.y = y0 + r * sin(u);
+  return (AtlasCreateColored(
+      dpy, c->root, DefaultVisual(dpy, c->screen),
+      DefaultDepth(dpy, c->screen), c->res.catColor,
+      eyes ? c->res.detailColor : c->res.background, width, height, nFrames));
+}
 
-    pts[i].x = (int)(((pt.z == 0.0 ? pt.x : pt.x / pt.z) * 23.0) + 12.0);
-    pts[i].y = (int)(((pt.z == 0.0 ? pt.y : pt.y / pt.z) * 23.0) + 11.0);
-  }
+/*
+ *  SetLevel - Switches c to quality level i: its tail count, frames and
+ *  atlases, at c's current scale.  The next frame is copied in full.
+ */
+void SetLevel(Clock *c, int i) {
+  CatLevel *l = &levels[i];
+  FrameSet *frames;
 
-  /*
-   *  Create pixmap for drawing eye (and stippling on update)
-   */
-  XFillPolygon(dpy, eyeBitmap, bitmapGC, pts, i, Nonconvex, CoordModeOrigin);
+  RenderAheadLock(ahead);
+  frames = FrameCacheGet(l->nTails, c->layout.scale);
+  FrameCacheRelease(c->frames);
+  c->frames = frames;
 
-  for (j = 0; j < i; j++) {
-    pts[j].x += 31;
+  if (c->tailAtlas[i] == NULL) {
+    c->tailAtlas[i] = CreateFrameAtlas(c, c->dpy, False, l->nTails + 1);
+  }
+  if (c->eyeAtlas[i] == NULL) {
+    c->eyeAtlas[i] = CreateFrameAtlas(c, c->dpy, True, l->nTails + 1);
   }
-  XFillPolygon(dpy, eyeBitmap, bitmapGC, pts, i, Nonconvex, CoordModeOrigin);
 
-  XFreeGC(dpy, bitmapGC);
+  c->level = i;
+  c->shownTail = -1;
+  RenderAheadChanged(ahead);
+  RenderAheadUnlock(ahead);
 
-  return (eyeBitmap);
+  if (!loadingIdle) {
+    XtAppAddWorkProc(appContext, LoadFramesIdle, NULL);
+    loadingIdle = True;
+  }
 }
 
-void InitializeCat(Pixel catColor, Pixel detailColor, Pixel tieColor) {
+/*
+ *  CreateCatTile - Paints the cat's body in c's colors, at c's scale,
+ *  into a new pixmap on the screen of root.  dpy is c's display or, to
+ *  make one for the shared frame cache, a second connection to the
+ *  same server.
+ *
+ *  The body is colored client side and sent in one XPutImage, rather
+ *  than stippled on the server from three uploaded bitmaps with a GC
+ *  each.  The image is 32 bit pixels in host order whatever the
+ *  server's format; Xlib converts if they differ.
+ */
+Pixmap CreateCatTile(Clock *c, Display *dpy, Window root) {
+  int depth = DefaultDepth(dpy, c->screen);
+  RasterImage *body;
+  XImage *image;
   Pixmap catPix;
-  Pixmap catBack;
-  Pixmap catWhite;
-  Pixmap catTie;
-  int fillStyle;
-  int i;
-  XGCValues gcv;
-  unsigned long valueMask;
-  GC gc1, gc2;
+  GC gc;
 
-  catPix = XCreatePixmap(dpy, root, DEF_CAT_WIDTH, DEF_CAT_HEIGHT,
-                         DefaultDepth(dpy, screen));
+  body = CatRenderBody(&c->catColors, c->layout.scale);
 
-  valueMask = GCForeground | GCBackground | GCGraphicsExposures;
+  image = XCreateImage(dpy, DefaultVisual(dpy, c->screen), depth, ZPixmap, 0,
+                       (char *)body->pixels, body->width, body->height, 32,
+                       body->stride * sizeof(uint32_t));
+  image->bits_per_pixel = 32;
+  image->byte_order = RasterHostByteOrder();
+  XInitImage(image);
 
-  gcv.background = appData.background;
-  gcv.foreground = catColor;
-  gcv.graphics_exposures = False;
-  gcv.line_width = 0;
-  gc1 = XCreateGC(dpy, root, valueMask, &gcv);
+  catPix = XCreatePixmap(dpy, root, body->width, body->height, depth);
+  gc = XCreateGC(dpy, catPix, 0, NULL);
+  XPutImage(dpy, catPix, gc, image, 0, 0, 0, 0, body->width, body->height);
+  XFreeGC(dpy, gc);
 
-  fillStyle = FillOpaqueStippled;
-  XSetFillStyle(dpy, gc1, fillStyle);
+  image->data = NULL;
+  XDestroyImage(image);
+  RasterImageDestroy(body);
 
-  catBack = XCreateBitmapFromData(dpy, root, catback_bits, catback_width,
-                                  catback_height);
+  return (catPix);
+}
 
-  XSetStipple(dpy, gc1, catBack);
-  XSetTSOrigin(dpy, gc1, 0, 0);
+/*
+ *  ShareAtlas - Makes a complete atlas of the tails or eyes in frameSet
+ *  on owner and publishes it under key.  Returns the pixmap to use,
+ *  which is someone else's if they got there first.
+ */
+Pixmap ShareAtlas(Clock *c, Display *owner, FrameSet *frameSet,
+                  const unsigned long *key, Bool eyes) {
+  FrameAtlas *atlas;
+  Pixmap pixmap;
+  int width, height;
+  int i;
 
-  XFillRectangle(dpy, catPix, gc1, 0, 0, DEF_CAT_WIDTH, DEF_CAT_HEIGHT);
+  atlas = CreateFrameAtlas(c, owner, eyes, frameSet->nTails + 1);
+  for (i = 0; i <= frameSet->nTails; i++) {
+    AtlasPut(owner, atlas, i,
+             eyes ? FrameSetEyes(frameSet, i) : FrameSetTail(frameSet, i));
+  }
 
-  fillStyle = FillStippled;
-  XSetFillStyle(dpy, gc1, fillStyle);
-  XFreeGC(dpy, gc1);
+  AtlasSize(atlas->frameWidth, atlas->frameHeight, atlas->nFrames, &width,
+            &height);
+  pixmap = ShareCachePublish(owner, c->root, key, atlas->pixmap, width,
+                             height, atlas->depth);
 
-  valueMask = GCForeground | GCBackground | GCGraphicsExposures;
+  atlas->shared = pixmap == atlas->pixmap;
+  AtlasDestroy(owner, atlas);
 
-  gcv.background = appData.background;
-  gcv.foreground = detailColor;
-  gcv.graphics_exposures = False;
-  gcv.line_width = 0;
-  gc2 = XCreateGC(dpy, root, valueMask, &gcv);
+  return (pixmap);
+}
 
-  fillStyle = FillStippled;
-  XSetFillStyle(dpy, gc2, fillStyle);
-  catWhite = XCreateBitmapFromData(dpy, root, catwhite_bits, catwhite_width,
-                                   catwhite_height);
+/*
+ *  ShareFrames - Gets c's body tile and the atlases of the default level
+ *  at c's scale from the frame cache every catclock on the server
+ *  shares, making and publishing whichever are not there yet.  What it
+ *  cannot get is left for c to make privately: the tile stays None,
+ *  the atlases NULL.
+ */
+void ShareFrames(Clock *c) {
+  CatLevel *l = &levels[DEF_LEVEL];
+  CatLayout *layout = &c->layout;
+  unsigned long tileKey[SHARE_KEY_SIZE];
+  unsigned long tailKey[SHARE_KEY_SIZE] = {SHARE_TAILS, 0, 0, 0, 0, 0};
+  unsigned long eyeKey[SHARE_KEY_SIZE] = {SHARE_EYES, 0, 0, 0, 0, 0};
+  int depth = DefaultDepth(c->dpy, c->screen);
+  int frameDepth = c->colorFrames ? depth : 1;
+  int tailWidth, tailHeight, eyeWidth, eyeHeight;
+  Pixmap tile, tails, eyes;
+  Display *owner;
+
+  tileKey[0] = SHARE_TILE;
+  tileKey[1] = tailKey[1] = eyeKey[1] = Round(layout->scale * 1000);
+  tileKey[2] = c->res.background;
+  tileKey[3] = c->res.catColor;
+  tileKey[4] = c->res.detailColor;
+  tileKey[5] = c->res.tieColor;
+  tailKey[2] = eyeKey[2] = l->nTails;
+  if (c->colorFrames) {
+    tailKey[0] = SHARE_COLOR_TAILS;
+    eyeKey[0] = SHARE_COLOR_EYES;
+    tailKey[3] = eyeKey[3] = c->res.catColor;
+    tailKey[4] = c->res.background;
+    eyeKey[4] = c->res.detailColor;
+  }
 
-  XSetStipple(dpy, gc2, catWhite);
-  XSetTSOrigin(dpy, gc2, 0, 0);
-  XFillRectangle(dpy, catPix, gc2, 0, 0, DEF_CAT_WIDTH, DEF_CAT_HEIGHT);
-  XFreeGC(dpy, gc2);
+  AtlasSize(layout->width, layout->tailHeight, l->nTails + 1, &tailWidth,
+            &tailHeight);
+  AtlasSize(layout->eyesWidth, layout->eyesHeight, l->nTails + 1, &eyeWidth,
+            &eyeHeight);
+
+  tile = ShareCacheFind(c->dpy, c->root, tileKey, layout->width,
+                        layout->height, depth);
+  tails = ShareCacheFind(c->dpy, c->root, tailKey, tailWidth, tailHeight,
+                         frameDepth);
+  eyes = ShareCacheFind(c->dpy, c->root, eyeKey, eyeWidth, eyeHeight,
+                        frameDepth);
+
+  if (tile == None || tails == None || eyes == None) {
+    owner = ShareCacheOpen(c->dpy);
+    if (owner != NULL) {
+      if (tile == None) {
+        Pixmap catPix = CreateCatTile(c, owner, c->root);
+
+        tile = ShareCachePublish(owner, c->root, tileKey, catPix,
+                                 layout->width, layout->height, depth);
+        if (tile != catPix) {
+          XFreePixmap(owner, catPix);
+        }
+      }
+      if (tails == None || eyes == None) {
+        FrameSet *frameSet = FrameCacheGet(l->nTails, layout->scale);
+
+        FrameSetRenderAll(frameSet);
+        if (tails == None) {
+          tails = ShareAtlas(c, owner, frameSet, tailKey, False);
+        }
+        if (eyes == None) {
+          eyes = ShareAtlas(c, owner, frameSet, eyeKey, True);
+        }
+        FrameCacheRelease(frameSet);
+      }
+      ShareCacheClose(owner);
+    }
+  }
 
-  gcv.background = appData.background;
-  gcv.foreground = tieColor;
-  gcv.graphics_exposures = False;
-  gcv.line_width = 0;
-  catGC = XCreateGC(dpy, root, valueMask, &gcv);
+  c->catTile = tile;
+  c->tileShared = tile != None;
+  if (tails != None) {
+    c->tailAtlas[DEF_LEVEL] = AtlasWrap(tails, frameDepth, layout->width,
+                                        layout->tailHeight, l->nTails + 1);
+  }
+  if (eyes != None) {
+    c->eyeAtlas[DEF_LEVEL] = AtlasWrap(eyes, frameDepth, layout->eyesWidth,
+                                       layout->eyesHeight, l->nTails + 1);
+  }
+}
 
-  fillStyle = FillStippled;
-  XSetFillStyle(dpy, catGC, fillStyle);
-  catTie = XCreateBitmapFromData(dpy, root, cattie_bits, cattie_width,
-                                 cattie_height);
+/*
+ *  InitializeShm - Sets up client side compositing for c, at its
+ *  current scale, if its display allows it.
+ */
+Bool InitializeShm(Clock *c) {
+  XWindowAttributes attributes;
 
-  XSetStipple(dpy, catGC, catTie);
-  XSetTSOrigin(dpy, catGC, 0, 0);
-  XFillRectangle(dpy, catPix, catGC, 0, 0, DEF_CAT_WIDTH, DEF_CAT_HEIGHT);
+  XGetWindowAttributes(c->dpy, c->window, &attributes);
 
-  /*
-   *  Now, let's create the Backround Pixmap for the Cat Clock using catGC
-   *  We will use this pixmap to fill in the window backround.
-   */
-  fillStyle = FillTiled;
-  XSetFillStyle(dpy, catGC, fillStyle);
-  XSetTile(dpy, catGC, catPix);
-  XSetTSOrigin(dpy, catGC, 0, 0);
+  c->shm = ShmFrameCreate(c->dpy, attributes.visual, attributes.depth,
+                          c->layout.width, c->layout.height,
+                          c->res.framesInFlight + 1);
+  if (c->shm == NULL) {
+    return (False);
+  }
 
-  /*
-   *  Create the arrays of tail and eye pixmaps
-   */
-  tailGC = CreateTailGC();
-  eyeGC = CreateEyeGC();
+  c->bodyImage = CatRenderBody(&c->catColors, c->layout.scale);
 
-  tailPixmap = (Pixmap *)malloc((appData.nTails + 1) * sizeof(Pixmap));
-  eyePixmap = (Pixmap *)malloc((appData.nTails + 1) * sizeof(Pixmap));
+  return (True);
+}
 
-  for (i = 0; i <= appData.nTails; i++) {
+/*
+ *  ScaleCat - Remakes everything c draws the cat with for a new scale.
+ *  The frame sets of the old scale stay in the frame cache a while.
+ */
+void ScaleCat(Clock *c) {
+  int i;
 
-    tailPixmap[i] = CreateTailPixmap(i * M_PI / (appData.nTails));
-    eyePixmap[i] = CreateEyePixmap(i * M_PI / (appData.nTails));
+  RenderAheadLock(ahead);
+  for (i = 0; i < N_LEVELS; i++) {
+    AtlasDestroy(c->dpy, c->tailAtlas[i]);
+    AtlasDestroy(c->dpy, c->eyeAtlas[i]);
+    c->tailAtlas[i] = c->eyeAtlas[i] = (FrameAtlas *)NULL;
   }
-}
-
-void UpdateEyesAndTail(void) {
-  static int curTail = 0; /*  Index into tail pixmap array       */
-  static int tailDir = 1; /*  Left or right swing                */
+  if (c->catTile != None && !c->tileShared) {
+    XFreePixmap(c->dpy, c->catTile);
+  }
+  c->catTile = None;
 
   /*
-   *  Draw new tail & eyes (Don't change values here!!)
+   *  Only what a clock starts with is shared.  Sets for the sizes it is
+   *  resized to, or tail counts set later, would pile up on the server
+   *  for good, so they are kept private.
    */
-  XCopyPlane(dpy, tailPixmap[curTail], clockWindow, tailGC, 0, 0, DEF_CAT_WIDTH,
-             TAIL_HEIGHT,
-             //               tailGC, 0, 0, DEF_CAT_WIDTH, tail_height,
-             0, DEF_CAT_BOTTOM + 1, 0x1);
-  XCopyPlane(dpy, eyePixmap[curTail], clockWindow, eyeGC, 0, 0, eyes_width,
-             eyes_height, 49, 30, 0x1);
+  if (c->shareScale == 0) {
+    c->shareScale = c->layout.scale;
+  }
+  if (appData.share && c->layout.scale == c->shareScale &&
+      levels[DEF_LEVEL].nTails == shareTails) {
+    ShareFrames(c);
+  }
+  if (c->catTile == None) {
+    c->catTile = CreateCatTile(c, c->dpy, c->root);
+    c->tileShared = False;
+  }
 
   /*
-   *  Figure out which tail & eyes are next
+   *  We will use this pixmap to fill in the window backround.
    */
+  XSetTile(c->dpy, c->catGC, c->catTile);
 
-  if (curTail == 0 && tailDir == -1) {
-    curTail = 1;
-    tailDir = 1;
-  } else if (curTail == appData.nTails && tailDir == 1) {
-    curTail = appData.nTails - 1;
-    tailDir = -1;
-  } else {
-    curTail += tailDir;
+  /*
+   *  Create the tail and eye atlases the frame cache did not provide,
+   *  empty.  Frames are rendered and uploaded when the pendulum first
+   *  gets to them, or earlier if the client is idle.
+   */
+  SetLevel(c, c->level);
+
+  if (c->shm != NULL) {
+    ShmFrameDestroy(c->shm);
+    RasterImageDestroy(c->bodyImage);
+    if (!InitializeShm(c)) {
+      fprintf(stderr, "xclock: MIT-SHM failed at %gx, drawing on the "
+                      "server\n",
+              c->layout.scale);
+    }
   }
+  RenderAheadChanged(ahead);
+  RenderAheadUnlock(ahead);
 }
 
-void EraseHands(Widget w, struct tm *tm) {
+/*
+ *  LayoutClock - Fits the cat to c's window, width x height: as large
+ *  as it fits, in SCALE_STEPS, and centered.  The hands follow.
+ */
+void LayoutClock(Clock *c, int width, int height) {
+  int steps = min(width * SCALE_STEPS / DEF_CAT_WIDTH,
+                  height * SCALE_STEPS / DEF_CAT_HEIGHT);
+  double scale = (double)max(steps, 1) / SCALE_STEPS;
+  Bool rescale = scale != c->layout.scale;
+
+  RenderAheadLock(ahead);
+  c->width = width;
+  c->height = height;
+
+  CatSetLayout(&c->layout, scale,
+               max((width - CatScaled(DEF_CAT_WIDTH, scale)) / 2, 0),
+               max((height - CatScaled(DEF_CAT_HEIGHT, scale)) / 2, 0));
+  XSetTSOrigin(c->dpy, c->catGC, c->layout.x, c->layout.y);
+
+  CatSetHands(&c->hands, c->layout.width, c->layout.height,
+              Round(appData.padding * scale));
+  c->hands.centerX += c->layout.x;
+  c->hands.centerY += c->layout.y;
+
+  c->numSegs = 0;
+  c->shownTail = -1;
+  c->secondShown = False;
+
+  if (rescale) {
+    ScaleCat(c);
+  }
+  RenderAheadChanged(ahead);
+  RenderAheadUnlock(ahead);
+}
 
-  (void *)w;
+/*
+ *  ScreenScale - The scale the cat starts out at on c's screen: the
+ *  scale resource, or else what makes it DEF_DPI sized.
+ */
+double ScreenScale(Clock *c) {
+  int widthMM = DisplayWidthMM(c->dpy, c->screen);
+  double dpi;
 
-  if (numSegs > 0) {
-    if (!tm || tm->tm_min != otm.tm_min || tm->tm_hour != otm.tm_hour) {
-      XDrawLines(dpy, clockWindow, eraseGC, segBuf, VERTICES_IN_HANDS + 2,
-                 CoordModeOrigin);
+  if (c->res.scale > 0.0) {
+    return (c->res.scale);
+  }
+  if (widthMM <= 0) {
+    return (1.0);
+  }
+  dpi = DisplayWidth(c->dpy, c->screen) * 25.4 / widthMM;
 
-      XDrawLines(dpy, clockWindow, eraseGC, &(segBuf[VERTICES_IN_HANDS + 2]),
-                 VERTICES_IN_HANDS, CoordModeOrigin);
+  return (max(floor(dpi / DEF_DPI * SCALE_STEPS) / SCALE_STEPS, 1.0));
+}
 
-      if (appData.handColor != appData.background) {
-        XFillPolygon(dpy, clockWindow, eraseGC, segBuf, VERTICES_IN_HANDS + 2,
-                     Convex, CoordModeOrigin);
+/*
+ *  CopyTime - Nanoseconds COPY_PROBE_FRAMES copies from src, of depth,
+ *  to dst take, round trip included.  The contents do not matter.
+ */
+int64_t CopyTime(Clock *c, Pixmap src, int depth, Drawable dst, int width,
+                 int height) {
+  int64_t start;
+  int i;
 
-        XFillPolygon(dpy, clockWindow, eraseGC,
-                     &(segBuf[VERTICES_IN_HANDS + 2]), VERTICES_IN_HANDS + 2,
-                     Convex, CoordModeOrigin);
-      }
+  XSync(c->dpy, False);
+  start = TimingNow();
+  for (i = 0; i < COPY_PROBE_FRAMES; i++) {
+    if (depth > 1) {
+      XCopyArea(c->dpy, src, dst, c->tailGC, 0, 0, width, height, 0, 0);
+    } else {
+      XCopyPlane(c->dpy, src, dst, c->tailGC, 0, 0, width, height, 0, 0,
+                 0x1);
     }
   }
+  XSync(c->dpy, False);
+
+  return (TimingNow() - start);
 }
 
-void Tick(Widget w, int add) {
-  static Bool beeped = False; /*  Beeped already?        */
-  time_t timeValue;           /*  What time is it?       */
-  time(&timeValue);
-  tm = *localtime(&timeValue);
+/*
+ *  ColorFramesFaster - Whether c's server copies a natural size tail
+ *  frame faster already colored than from a bitmap.  The copies go to
+ *  a pixmap rather than the window, which may not be mapped yet.
+ */
+Bool ColorFramesFaster(Clock *c) {
+  int depth = DefaultDepth(c->dpy, c->screen);
+  Pixmap bits, colored, dst;
+  int64_t planeTime, areaTime;
 
-  /*
-   *  If ticking is to continue, add the next timeout
-   */
-  if (add) {
-    XtAppAddTimeOut(appContext, appData.update, (XtTimerCallbackProc)Tick, w);
-  }
+  bits = XCreatePixmap(c->dpy, c->root, DEF_CAT_WIDTH, TAIL_HEIGHT, 1);
+  colored = XCreatePixmap(c->dpy, c->root, DEF_CAT_WIDTH, TAIL_HEIGHT, depth);
+  dst = XCreatePixmap(c->dpy, c->root, DEF_CAT_WIDTH, TAIL_HEIGHT, depth);
 
   /*
-   *  Beep on the half hour; double-beep on the hour.
+   *  Once each first, so neither is billed for warming up
    */
-  if (appData.chime) {
-    if (beeped && (tm.tm_min != 30) && (tm.tm_min != 0)) {
+  CopyTime(c, bits, 1, dst, DEF_CAT_WIDTH, TAIL_HEIGHT);
+  CopyTime(c, colored, depth, dst, DEF_CAT_WIDTH, TAIL_HEIGHT);
+  planeTime = CopyTime(c, bits, 1, dst, DEF_CAT_WIDTH, TAIL_HEIGHT);
+  areaTime = CopyTime(c, colored, depth, dst, DEF_CAT_WIDTH, TAIL_HEIGHT);
+
+  XFreePixmap(c->dpy, bits);
+  XFreePixmap(c->dpy, colored);
+  XFreePixmap(c->dpy, dst);
+
+  return (areaTime < planeTime);
+}
+
+void InitializeCat(Clock *c) {
+  XGCValues gcv;
+  unsigned long valueMask;
+  Dimension width, height;
+
+  /*
+   *  Now, let's create the Backround Pixmap for the Cat Clock using catGC
+   */
+  valueMask = GCForeground | GCBackground | GCGraphicsExposures;
+
+  gcv.background = c->res.background;
+  gcv.foreground = c->res.tieColor;
+  gcv.graphics_exposures = False;
+  c->catGC = XCreateGC(c->dpy, c->root, valueMask, &gcv);
+
+  XSetFillStyle(c->dpy, c->catGC, FillTiled);
+
+  c->tailGC = CreateTailGC(c);
+  c->eyeGC = CreateEyeGC(c);
+
+  /*
+   *  The body is colored client side, so the renderer gets the
+   *  allocated pixel values
+   */
+  c->catColors.background = c->res.background;
+  c->catColors.catColor = c->res.catColor;
+  c->catColors.detailColor = c->res.detailColor;
+  c->catColors.tieColor = c->res.tieColor;
+  c->catColors.handColor = c->res.handColor;
+  c->catColors.highlightColor = c->res.highlightColor;
+
+  if (strcmp(c->res.copyMode, "area") == 0) {
+    c->colorFrames = True;
+  } else if (strcmp(c->res.copyMode, "plane") != 0) {
+    c->colorFrames = ColorFramesFaster(c);
+  }
+
+  XtVaGetValues(c->canvas, XmNwidth, &width, XmNheight, &height, NULL);
+  LayoutClock(c, width, height);
+}
+
+/*
+ *  CopyAtlasFrame - Copies all of frame of atlas to c's window at x, y,
+ *  through whatever clip gc has.
+ */
+void CopyAtlasFrame(Clock *c, const FrameAtlas *atlas, int frame, GC gc,
+                    int x, int y) {
+  int srcX, srcY;
+
+  AtlasOrigin(atlas, frame, &srcX, &srcY);
+  if (atlas->depth > 1) {
+    XCopyArea(c->dpy, atlas->pixmap, c->window, gc, srcX, srcY,
+              atlas->frameWidth, atlas->frameHeight, x, y);
+  } else {
+    XCopyPlane(c->dpy, atlas->pixmap, c->window, gc, srcX, srcY,
+               atlas->frameWidth, atlas->frameHeight, x, y, 0x1);
+  }
+}
+
+/*
+ *  CopyFrame - Copies frame of atlas to c's window at x, y: only
+ *  the rectangles in delta, or all of it if there is no delta.  The
+ *  rectangles go in as the GC's clip list, so the whole delta costs one
+ *  SetClipRectangles and one CopyPlane (CopyArea for a colored atlas);
+ *  *clipped tracks whether the GC still has a clip list from last time.
+ */
+void CopyFrame(Clock *c, const FrameAtlas *atlas, int frame, GC gc,
+               Bool *clipped, const FrameDelta *delta, int x, int y) {
+  if (delta != NULL) {
+    if (delta->count == 0) {
+      return;
+    }
+    XSetClipRectangles(c->dpy, gc, x, y, delta->rects, delta->count,
+                       Unsorted);
+    *clipped = True;
+  } else if (*clipped) {
+    XSetClipMask(c->dpy, gc, None);
+    *clipped = False;
+  }
+
+  CopyAtlasFrame(c, atlas, frame, gc, x, y);
+}
+
+/*
+ *  PendulumFrame - Which of nTails tails & eyes go with monotonic time
+ *  when.  Late ticks skip frames rather than slow the cat down.
+ */
+int PendulumFrame(int64_t when, int nTails) {
+  return (CatPendulumFrame(when - swingEpoch, nTails));
+}
+
+/*
+ *  PlanTailDelta, PlanEyeDelta - What plan says changed since the frame
+ *  on c's screen; NULL, all of it, if plan was made from another one.
+ */
+#define PlanTailDelta(c, plan)                                                 \
+  ((plan)->fromTail == (c)->shownTail ? (plan)->tailDelta : NULL)
+#define PlanEyeDelta(c, plan)                                                  \
+  ((plan)->fromTail == (c)->shownTail ? (plan)->eyeDelta : NULL)
+
+void UpdateEyesAndTail(Clock *c, const FramePlan *plan) {
+  CatLayout *l = &c->layout;
+  int curTail = plan->tail;
+  TrafficMark mark;
+  int64_t traceStart;
+
+  /*
+   *  Draw new tail & eyes (Don't change values here!!)
+   *  Stepping from a neighbouring frame only needs the pixels that
+   *  differ between the two, and staying on the same one needs none.
+   */
+  if (curTail == c->shownTail) {
+    return;
+  }
+
+  traceStart = TraceBegin();
+  MetricsMark(c->dpy, &mark);
+  LoadFrame(c, curTail);
+  CopyFrame(c, c->tailAtlas[c->level], curTail, c->tailGC, &c->tailClipped,
+            PlanTailDelta(c, plan), l->x, l->y + l->tailY);
+  CopyFrame(c, c->eyeAtlas[c->level], curTail, c->eyeGC, &c->eyeClipped,
+            PlanEyeDelta(c, plan), l->x + l->eyesX, l->y + l->eyesY);
+  c->shownTail = curTail;
+  MetricsTraffic(c->dpy, &mark, &metrics.tailRequests, &metrics.tailBytes);
+  TraceEnd("UpdateEyesAndTail", traceStart, ClockTrack(c));
+}
+
+/*
+ *  PutRegion - Sends the part of c's composed frame that delta says
+ *  changed in the width x height area at x, y (all of it if no delta).
+ *  The frame holds just the cat, so x, y are relative to its corner.
+ */
+void PutRegion(Clock *c, const FrameDelta *delta, int x, int y, int width,
+               int height) {
+  int x0, y0, x1, y1;
+  int i;
+
+  if (delta != NULL) {
+    if (delta->count == 0) {
+      return;
+    }
+
+    x0 = y0 = 0x7fff;
+    x1 = y1 = 0;
+    for (i = 0; i < delta->count; i++) {
+      x0 = min(x0, delta->rects[i].x);
+      y0 = min(y0, delta->rects[i].y);
+      x1 = max(x1, delta->rects[i].x + delta->rects[i].width);
+      y1 = max(y1, delta->rects[i].y + delta->rects[i].height);
+    }
+    x += x0;
+    y += y0;
+    width = x1 - x0;
+    height = y1 - y0;
+  }
+
+  ShmFramePut(c->shm, c->window, c->gc, x, y, width, height, c->layout.x,
+              c->layout.y);
+}
+
+/*
+ *  ComposeFrame - The MIT-SHM counterpart of drawing the hands and
+ *  calling UpdateEyesAndTail: the whole frame is composed client side
+ *  and only what changed on screen is put.
+ */
+void ComposeFrame(Clock *c, Bool handsChanged, const FramePlan *plan) {
+  CatLayout *l = &c->layout;
+  const XPoint *secondPts = plan->second;
+  int curTail = plan->tail;
+  Bool secondMoved = False;
+  XRectangle box;
+  RasterImage *image;
+  int64_t traceStart;
+
+  if (secondHand != SECONDS_NONE) {
+    secondMoved = !c->secondShown ||
+                  memcmp(secondPts, c->secondPts, sizeof(c->secondPts)) != 0;
+  }
+  if (!handsChanged && curTail == c->shownTail && !secondMoved) {
+    return;
+  }
+  traceStart = TraceBegin();
+
+  if (handsChanged) {
+    memcpy(c->segBuf, plan->hands, sizeof(plan->hands));
+    c->numSegs = 2 * (VERTICES_IN_HANDS + 2);
+  }
+
+  image = ShmFrameNext(c->shm);
+  CatRenderFrame(image, c->bodyImage, FrameSetTail(c->frames, curTail),
+                 FrameSetEyes(c->frames, curTail), &c->catColors, &c->hands,
+                 l, &plan->tm);
+  if (secondHand != SECONDS_NONE) {
+    CatRenderSecond(image, &c->catColors, secondPts, l);
+  }
+
+  if (handsChanged || c->shownTail < 0) {
+    ShmFramePut(c->shm, c->window, c->gc, 0, 0, l->width, l->height, l->x,
+                l->y);
+  } else {
+    if (curTail != c->shownTail) {
+      PutRegion(c, PlanTailDelta(c, plan), 0, l->tailY, l->width,
+                l->tailHeight);
+      PutRegion(c, PlanEyeDelta(c, plan), l->eyesX, l->eyesY, l->eyesWidth,
+                l->eyesHeight);
+    }
+
+    /*
+     *  The old second hand and the new one, in one put
+     */
+    if (secondMoved) {
+      int x0, y0, x1, y1;
+
+      CatPointsBox(secondPts, SECOND_HAND_PTS, &box);
+      x0 = box.x;
+      y0 = box.y;
+      x1 = box.x + box.width;
+      y1 = box.y + box.height;
+      if (c->secondShown) {
+        CatPointsBox(c->secondPts, SECOND_HAND_PTS, &box);
+        x0 = min(x0, box.x);
+        y0 = min(y0, box.y);
+        x1 = max(x1, box.x + box.width);
+        y1 = max(y1, box.y + box.height);
+      }
+      ShmFramePut(c->shm, c->window, c->gc, x0 - l->x, y0 - l->y, x1 - x0,
+                  y1 - y0, l->x, l->y);
+    }
+  }
+  c->shownTail = curTail;
+  if (secondHand != SECONDS_NONE) {
+    memcpy(c->secondPts, secondPts, sizeof(c->secondPts));
+    c->secondShown = True;
+  }
+  TraceEnd("ComposeFrame", traceStart, ClockTrack(c));
+}
+
+void EraseHands(Clock *c, struct tm *tm) {
+  if (c->numSegs > 0) {
+    if (!tm || tm->tm_min != c->otm.tm_min || tm->tm_hour != c->otm.tm_hour) {
+      XDrawLines(c->dpy, c->window, c->eraseGC, c->segBuf,
+                 VERTICES_IN_HANDS + 2, CoordModeOrigin);
+
+      XDrawLines(c->dpy, c->window, c->eraseGC,
+                 &(c->segBuf[VERTICES_IN_HANDS + 2]), VERTICES_IN_HANDS,
+                 CoordModeOrigin);
+
+      if (c->res.handColor != c->res.background) {
+        XFillPolygon(c->dpy, c->window, c->eraseGC, c->segBuf,
+                     VERTICES_IN_HANDS + 2, Convex, CoordModeOrigin);
+
+        XFillPolygon(c->dpy, c->window, c->eraseGC,
+                     &(c->segBuf[VERTICES_IN_HANDS + 2]),
+                     VERTICES_IN_HANDS + 2, Convex, CoordModeOrigin);
+      }
+    }
+  }
+}
+
+/*
+ *  Chime - Beep on the half hour; double-beep on the hour, once on
+ *  every display.
+ */
+void Chime(const struct tm *now) {
+  static Bool beeped = False; /*  Beeped already?        */
+  int i;
+
+  if (appData.chime) {
+    if (beeped && (now->tm_min != 30) && (now->tm_min != 0)) {
       beeped = 0;
     }
-    if (((tm.tm_min == 30) || (tm.tm_min == 0)) && (!beeped)) {
+    if (((now->tm_min == 30) || (now->tm_min == 0)) && (!beeped)) {
       beeped = 1;
-      XBell(dpy, 100);
-      if (tm.tm_min == 0) {
-        XBell(dpy, 100);
+      for (i = 0; i < nClocks; i++) {
+        if (clocks[i].bell) {
+          XBell(clocks[i].dpy, 100);
+          if (now->tm_min == 0) {
+            XBell(clocks[i].dpy, 100);
+          }
+        }
       }
     }
   }
+}
+
+/*
+ *  UpdateTime - Reads the time every clock is about to show, and chimes.
+ *  The render-ahead thread plans from the same reading, so it is
+ *  changed under the lock.
+ */
+void UpdateTime(void) {
+  int64_t traceStart = TraceBegin();
+  struct tm now;
+  long nsec;
+  int64_t read;
+
+  WallClockNow(&now, &nsec);
+  read = TimingNow();
+  TraceEnd("WallClockNow", traceStart, TRACE_SCHED);
+
+  Chime(&now);
+
+  /*
+   *  12 hour clock.
+   */
+  if (now.tm_hour > 12) {
+    now.tm_hour -= 12;
+  }
+
+  RenderAheadLock(ahead);
+  tm = now;
+  tmNsec = nsec;
+  tmRead = read;
+  RenderAheadUnlock(ahead);
+}
+
+/*
+ *  MakePlan - Works out everything about frame when of c but its
+ *  requests: the tail and eyes, what changed since frame fromTail (-1
+ *  if none), and the hands at time tm, nsec into its second.  It runs
+ *  on the render-ahead thread too, holding the lock, so it reads only
+ *  what the lock guards and makes no X calls.
+ */
+void MakePlan(Clock *c, int64_t when, const struct tm *tm, long nsec,
+              int fromTail, FramePlan *plan) {
+  plan->tm = *tm;
+  plan->nsec = nsec;
+  plan->tail = PendulumFrame(when, levels[c->level].nTails);
+  plan->fromTail = fromTail;
+
+  FrameSetRender(c->frames, plan->tail);
+  plan->tailDelta = FrameSetTailDelta(c->frames, fromTail, plan->tail);
+  plan->eyeDelta = FrameSetEyeDelta(c->frames, fromTail, plan->tail);
 
   /*
    *  The second (or minute) hand is sec (or min)
@@ -876,74 +1427,659 @@ void Tick(Widget w, int add) {
    *  clock-face.  The derivation is left as an excercise
    *  for the reader.
    */
+  CatHandPoints(&c->hands, c->hands.minuteHandLength, c->hands.handWidth,
+                ((double)tm->tm_min) / 60.0, plan->hands);
+  CatHandPoints(&c->hands, c->hands.hourHandLength, c->hands.handWidth,
+                ((((double)tm->tm_hour) + (((double)tm->tm_min) / 60.0)) /
+                 12.0),
+                &plan->hands[VERTICES_IN_HANDS + 2]);
+  if (secondHand != SECONDS_NONE) {
+    CatSecondPoints(&c->hands, CatSecondFraction(tm, nsec, secondHand),
+                    plan->second);
+  }
+}
+
+/*
+ *  PlanAhead - The render-ahead thread's PlanProc: plans frame when of
+ *  clocks[i] for the local time it will be then, which is the time
+ *  UpdateTime last read moved on arithmetically.  A plan that crosses
+ *  into a minute with another UTC offset is turned down by PlanFits.
+ */
+void PlanAhead(void *closure, int i, int64_t when, const FramePlan *prev,
+               FramePlan *plan) {
+  struct tm then = tm;
+  int64_t at = tmNsec + max(when - tmRead, 0);
+  int64_t seconds, minutes;
+
+  (void *)closure;
+
+  seconds = then.tm_sec + at / 1000000000;
+  minutes = then.tm_min + seconds / 60;
+  then.tm_sec = (int)(seconds % 60);
+  then.tm_min = (int)(minutes % 60);
+  then.tm_hour += (int)(minutes / 60);
+  while (then.tm_hour > 12) {
+    then.tm_hour -= 12;
+  }
+
+  MakePlan(&clocks[i], when, &then, (long)(at % 1000000000),
+           prev != NULL ? prev->tail : -1, plan);
+}
+
+/*
+ *  PlanFits - Whether plan, made ahead, shows the time UpdateTime read.
+ */
+Bool PlanFits(const FramePlan *plan) {
+  return (plan->tm.tm_min == tm.tm_min && plan->tm.tm_hour == tm.tm_hour &&
+          (secondHand == SECONDS_NONE || plan->tm.tm_sec == tm.tm_sec));
+}
+
+/*
+ *  DrawPlan - Generates the requests for frame plan of c: hands if the
+ *  time has moved on, then the tail and eyes, then the second hand.
+ *  Nothing is flushed.
+ */
+void DrawPlan(Clock *c, const FramePlan *plan) {
+  Bool handsChanged = c->numSegs == 0 ||
+                      plan->tm.tm_min != c->otm.tm_min ||
+                      plan->tm.tm_hour != c->otm.tm_hour;
+
+  metrics.framesDrawn++;
+  metrics.handRedraws += handsChanged;
+
+  if (c->shm != NULL) {
+    ComposeFrame(c, handsChanged, plan);
+    c->otm = plan->tm;
+    return;
+  }
+
+  if (handsChanged) {
+
+    DrawClockFace(c);
+
+    /*
+     *  Fill in the minute hand with its color and then
+     *  outline it.  Next, do the same with the hour hand.
+     *  This is a cheap hidden line algorithm.
+     */
+    memcpy(c->segBuf, plan->hands, sizeof(plan->hands));
+    c->numSegs = 2 * (VERTICES_IN_HANDS + 2);
+
+    if (c->res.handColor != c->res.background) {
+      XFillPolygon(c->dpy, c->window, c->handGC, c->segBuf,
+                   VERTICES_IN_HANDS + 2, Convex, CoordModeOrigin);
+    }
+
+    XDrawLines(c->dpy, c->window, c->highGC, c->segBuf, VERTICES_IN_HANDS + 2,
+               CoordModeOrigin);
+
+    if (c->res.handColor != c->res.background) {
+      XFillPolygon(c->dpy, c->window, c->handGC,
+                   &(c->segBuf[VERTICES_IN_HANDS + 2]), VERTICES_IN_HANDS + 2,
+                   Convex, CoordModeOrigin);
+    }
+
+    XDrawLines(c->dpy, c->window, c->highGC,
+               &(c->segBuf[VERTICES_IN_HANDS + 2]), VERTICES_IN_HANDS + 2,
+               CoordModeOrigin);
+
+    if (secondHand != SECONDS_NONE) {
+      SaveSecondFace(c);
+    }
+  }
+
+  UpdateEyesAndTail(c, plan);
+  if (secondHand != SECONDS_NONE) {
+    DrawSecond(c, plan->second);
+  }
+
+  c->otm = plan->tm;
+}
+
+/*
+ *  DrawFrame - Plans frame when of c from the time UpdateTime read, on
+ *  the spot, and draws it.
+ */
+void DrawFrame(Clock *c, int64_t when) {
+  FramePlan plan;
+  int64_t traceStart = TraceBegin();
+
+  RenderAheadLock(ahead);
+  MakePlan(c, when, &tm, tmNsec, c->shownTail, &plan);
+  TraceEnd("MakePlan", traceStart, ClockTrack(c));
+  DrawPlan(c, &plan);
+  RenderAheadUnlock(ahead);
+}
+
+/*
+ *  FramePeriod - Nanoseconds between frames: the fps resource, or by
+ *  default one frame per tail per second, for the clock with the most
+ *  tails; longer if that would send more than the bandwidth budget.
+ */
+int64_t FramePeriod(void) {
+  int nTails = 1;
+  int i;
+
+  for (i = 0; i < nClocks; i++) {
+    nTails = max(nTails, levels[clocks[i].level].nTails);
+  }
+
+  return (BudgetPeriod(&budget, (int64_t)1000000000 /
+                                    (appData.fps > 0 ? appData.fps : nTails)));
+}
+
+/*
+ *  Tick - Called by the scheduler on every frame deadline.  Missed
+ *  deadlines are simply dropped; if the wall clock jumped, the hands are
+ *  redrawn straight away instead of at the next minute.  Every clock
+ *  that can be seen gets a frame, and what the frames send is counted
+ *  against the bandwidth budget.
+ */
+void Tick(XtPointer closure, int skipped, Boolean jumped) {
+  Bool changed = False;
+  int64_t traceStart = TraceBegin();
+  int64_t now;
+  long bytes = 0;
+  int i;
+
+  (void *)closure;
+
+  metrics.framesSkipped += skipped;
+  MetricsLateness(SchedLateness());
+
+  UpdateTime();
+
+  /*
+   *  Nobody is looking: just keep the chime going, on the minute.
+   */
+  if (paused) {
+    if (jumped) {
+      SchedSetPeriodAligned(PAUSED_PERIOD);
+    }
+    return;
+  }
 
   /*
-   *  12 hour clock.
+   *  Plans made ahead are for a wall clock that is no longer right
    */
-  if (tm.tm_hour > 12) {
-    tm.tm_hour -= 12;
+  if (jumped) {
+    RenderAheadLock(ahead);
+    RenderAheadChanged(ahead);
+    RenderAheadUnlock(ahead);
   }
+  RenderAheadSchedule(ahead, SchedDeadline(), SchedGetPeriod());
 
-  if (numSegs == 0 || tm.tm_min != otm.tm_min || tm.tm_hour != otm.tm_hour) {
+  now = TimingNow();
+  for (i = 0; i < nClocks; i++) {
+    Clock *c = &clocks[i];
+    FramePlan plan;
+    TrafficMark mark;
+    int next;
 
-    segBufPtr = segBuf;
-    numSegs = 0;
+    if (ClockHidden(c)) {
+      continue;
+    }
+    if (jumped) {
+      c->numSegs = 0;
+    }
 
-    DrawClockFace();
+    MetricsMark(c->dpy, &mark);
+    if (RenderAheadTake(ahead, i, SchedDeadline(), &plan) &&
+        PlanFits(&plan)) {
+      metrics.framesPlanned++;
+      DrawPlan(c, &plan);
+    } else {
+      DrawFrame(c, now);
+    }
+    PresentFrame(c->present);
+    bytes += MetricsTraffic(c->dpy, &mark, &metrics.frameRequests,
+                            &metrics.frameBytes);
+    TraceEnd("frame", now, ClockTrack(c));
 
     /*
-     *  Calculate the minute hand, fill it in with its
-     *  color and then outline it.  Next, do the same
-     *  with the hour hand.  This is a cheap hidden
-     *  line algorithm.
+     *  Let the governor trade tails for server time, as far as the
+     *  bandwidth budget allows
      */
-    DrawHand(minuteHandLength, handWidth, ((double)tm.tm_min) / 60.0);
-    if (appData.handColor != appData.background) {
-      XFillPolygon(dpy, clockWindow, handGC, segBuf, VERTICES_IN_HANDS + 2,
-                   Convex, CoordModeOrigin);
+    next = DEF_LEVEL;
+    if (appData.governor) {
+      next = GovernorUpdate(&c->governor, PresentLatency(c->present),
+                            SchedGetPeriod());
     }
+    next = BudgetLevel(&budget, next);
+    if (next != c->level) {
+      SetLevel(c, next);
+      changed = True;
+    }
+  }
 
-    XDrawLines(dpy, clockWindow, highGC, segBuf, VERTICES_IN_HANDS + 2,
-               CoordModeOrigin);
+  if (BudgetUpdate(&budget, bytes, (skipped + 1) * SchedGetPeriod())) {
+    changed = True;
+  }
+  metrics.bandwidth = BudgetRate(&budget);
 
-    DrawHand(hourHandLength, handWidth,
-             ((((double)tm.tm_hour) + (((double)tm.tm_min) / 60.0)) / 12.0));
+  if (changed) {
+    SchedSetPeriod(FramePeriod());
+  }
 
-    if (appData.handColor != appData.background) {
-      XFillPolygon(dpy, clockWindow, handGC, &(segBuf[VERTICES_IN_HANDS + 2]),
-                   VERTICES_IN_HANDS + 2, Convex, CoordModeOrigin);
+  TraceEnd("Tick", traceStart, TRACE_SCHED);
+}
+
+/*
+ *  RedrawClock - Draws all of c now, rather than at the next tick.
+ */
+void RedrawClock(Clock *c) {
+  c->numSegs = 0;
+  UpdateTime();
+  DrawFrame(c, TimingNow());
+  PresentFrame(c->present);
+}
+
+/*
+ *  UpdateVisibility - Brings c straight up to date when it can be seen
+ *  again, and pauses the animation once no clock can be.
+ */
+void UpdateVisibility(Clock *c, Bool wasHidden) {
+  Bool hidden = True;
+  int i;
+
+  for (i = 0; i < nClocks; i++) {
+    hidden = hidden && ClockHidden(&clocks[i]);
+  }
+  hidden = hidden || held;
+
+  if (hidden != paused) {
+    paused = metrics.paused = hidden;
+    if (paused) {
+      SchedSetPeriodAligned(PAUSED_PERIOD);
+      return;
+    }
+    SchedSetPeriod(FramePeriod());
+  }
+
+  if (!paused && wasHidden && !ClockHidden(c)) {
+    RedrawClock(c);
+  }
+}
+
+void HandleVisibility(Widget w, XtPointer clientData, XEvent *event,
+                      Boolean *continueToDispatch) {
+  Clock *c = (Clock *)clientData;
+  Bool wasHidden = ClockHidden(c);
+
+  (void *)w;
+  (void *)continueToDispatch;
+
+  if (event->type == VisibilityNotify) {
+    c->obscured = event->xvisibility.state == VisibilityFullyObscured;
+    UpdateVisibility(c, wasHidden);
+  }
+}
+
+void HandleStructure(Widget w, XtPointer clientData, XEvent *event,
+                     Boolean *continueToDispatch) {
+  Clock *c = (Clock *)clientData;
+  Bool wasHidden = ClockHidden(c);
+
+  (void *)w;
+  (void *)continueToDispatch;
+
+  if (event->type == MapNotify || event->type == UnmapNotify) {
+    c->mapped = event->type == MapNotify;
+    UpdateVisibility(c, wasHidden);
+  }
+}
+
+/*
+ *  PollBlank - Screen savers and DPMS do not tell us when they kick in,
+ *  so ask every BLANK_POLL_INTERVAL, on every display.
+ */
+void PollBlank(XtPointer closure, XtIntervalId *id) {
+  int i;
+
+  (void *)id;
+
+  for (i = 0; i < nClocks; i++) {
+    Clock *c = &clocks[i];
+    Bool wasHidden = ClockHidden(c);
+
+    c->blanked = BlankQuery(c->dpy);
+    UpdateVisibility(c, wasHidden);
+  }
+
+  XtAppAddTimeOut(appContext, BLANK_POLL_INTERVAL, PollBlank, closure);
+}
+
+/*
+ *  SetTails - Sets the tail resolution of the default level, and from
+ *  it the others.  Clocks already running get new atlases.
+ */
+void SetTails(int nTails) {
+  int i;
+
+  RenderAheadLock(ahead);
+  appData.nTails = metrics.nTails = nTails;
+  for (i = 0; i < N_LEVELS; i++) {
+    levels[i].nTails = max(nTails >> (DEF_LEVEL - i), 1);
+  }
+
+  for (i = 0; i < nClocks; i++) {
+    if (clocks[i].catGC != NULL) {
+      ScaleCat(&clocks[i]);
+    }
+  }
+  RenderAheadChanged(ahead);
+  RenderAheadUnlock(ahead);
+  if (nClocks > 0 && !paused) {
+    SchedSetPeriod(FramePeriod());
+  }
+}
+
+/*
+ *  ParseCount - Reads arg, all of it, into n if it is a whole number
+ *  from low to high.  Returns whether it was.
+ */
+Bool ParseCount(const char *arg, long low, long high, int *n) {
+  char *end;
+  long value;
+
+  if (arg == NULL) {
+    return (False);
+  }
+
+  errno = 0;
+  value = strtol(arg, &end, 10);
+  if (end == arg || *end != '\0' || errno != 0 || value < low ||
+      value > high) {
+    return (False);
+  }
+
+  *n = (int)value;
+
+  return (True);
+}
+
+/*
+ *  ControlCommand - Carries out a command from the control socket.
+ */
+const char *ControlCommand(const char *command, const char *arg) {
+  int n, i;
+
+  if (strcmp(command, "fps") == 0) {
+    if (!ParseCount(arg, 0, MAX_FPS, &n)) {
+      return ("fps needs a rate from 0 to " MAX_FPS_STRING
+              ", 0 for one frame per tail");
+    }
+    appData.fps = n;
+    if (!paused) {
+      SchedSetPeriod(FramePeriod());
+    }
+  } else if (strcmp(command, "tails") == 0) {
+    if (!ParseCount(arg, 1, MAX_N_TAILS, &n)) {
+      return ("tails needs a count from 1 to " MAX_N_TAILS_STRING);
+    }
+    SetTails(n);
+  } else if (strcmp(command, "bandwidth") == 0) {
+    if (!ParseCount(arg, 0, INT_MAX, &n)) {
+      return ("bandwidth needs bytes a second, 0 for no limit");
+    }
+    appData.bandwidth = n;
+    BudgetSet(&budget, n);
+    metrics.budget = n;
+    if (!paused) {
+      SchedSetPeriod(FramePeriod());
+    }
+  } else if (strcmp(command, "pause") == 0) {
+    held = True;
+    UpdateVisibility(&clocks[0], False);
+  } else if (strcmp(command, "resume") == 0) {
+    held = False;
+    for (i = 0; i < nClocks; i++) {
+      UpdateVisibility(&clocks[i], True);
+    }
+  } else {
+    return ("unknown command; try help");
+  }
+
+  return ((const char *)NULL);
+}
+
+/*
+ *  RunBenchmark - Draws frames of c back to back (or paced at rate
+ *  frames per second, if rate is positive) and reports throughput and
+ *  latency, first with each frame only flushed, then pipelined behind
+ *  fences the way Tick presents them, then with a round trip to the
+ *  server after every frame.
+ */
+void RunBenchmark(Clock *c, int frames, int rate) {
+  static const char *labels[] = {"flush", "fence", "sync"};
+  LatencyStats stats;
+  int64_t start, next, t0;
+  int nTails = levels[c->level].nTails;
+  int pass, i;
+
+  XSync(c->dpy, False);
+
+  for (pass = 0; pass < 3; pass++) {
+    LatencyInit(&stats, frames);
+
+    start = next = TimingNow();
+    for (i = 0; i < frames; i++) {
+      if (rate > 0) {
+        next += 1000000000 / rate;
+        TimingSleepUntil(next);
+      }
+
+      t0 = TimingNow();
+      UpdateTime();
+      DrawFrame(c, swingEpoch + i * (SWING_PERIOD / 2) / nTails);
+      if (pass == 0) {
+        XFlush(c->dpy);
+      } else if (pass == 1) {
+        PresentFrame(c->present);
+      } else {
+        XSync(c->dpy, False);
+      }
+      LatencyAdd(&stats, (TimingNow() - t0) / 1e6);
+    }
+
+    /*
+     *  Drain the flushed pass so it is not billed to the next one
+     */
+    XSync(c->dpy, False);
+    LatencyReport(stdout, labels[pass], &stats, TimingNow() - start);
+    LatencyFree(&stats);
+  }
+}
+
+/*
+ *  Overlaps - Whether any of the w x h box at x, y is in region.
+ */
+static Bool Overlaps(Region region, int x, int y, int w, int h) {
+  return (XRectInRegion(region, x, y, w, h) != RectangleOut);
+}
+
+/*
+ *  RepaintHands - Draws the minute and hour hands, and the second hand
+ *  if it is up, where they meet c->damage.  handGC and highGC are left
+ *  clipped to it only while that is done.
+ */
+static void RepaintHands(Clock *c) {
+  XPoint *pts[3];
+  int nPts[3];
+  Bool clipped = False;
+  XRectangle box;
+  int i;
+
+  pts[0] = c->segBuf;
+  pts[1] = &c->segBuf[VERTICES_IN_HANDS + 2];
+  nPts[0] = nPts[1] = VERTICES_IN_HANDS + 2;
+  pts[2] = c->secondPts;
+  nPts[2] = c->secondShown ? SECOND_HAND_PTS : 0;
+
+  for (i = 0; i < 3; i++) {
+    if (nPts[i] == 0) {
+      continue;
+    }
+    CatPointsBox(pts[i], nPts[i], &box);
+    if (!Overlaps(c->damage, box.x, box.y, box.width, box.height)) {
+      continue;
     }
 
-    XDrawLines(dpy, clockWindow, highGC, &(segBuf[VERTICES_IN_HANDS + 2]),
-               VERTICES_IN_HANDS + 2, CoordModeOrigin);
+    if (!clipped) {
+      XSetRegion(c->dpy, c->handGC, c->damage);
+      XSetRegion(c->dpy, c->highGC, c->damage);
+      clipped = True;
+    }
+    if (c->res.handColor != c->res.background) {
+      XFillPolygon(c->dpy, c->window, c->handGC, pts[i], nPts[i], Convex,
+                   CoordModeOrigin);
+    }
+    XDrawLines(c->dpy, c->window, c->highGC, pts[i], nPts[i],
+               CoordModeOrigin);
   }
 
-  UpdateEyesAndTail();
+  if (clipped) {
+    XSetClipMask(c->dpy, c->handGC, None);
+    XSetClipMask(c->dpy, c->highGC, None);
+  }
+}
 
-  otm = tm;
-  XSync(dpy, False);
+/*
+ *  RepaintFrame - Copies the tail or eye frame on screen back where it
+ *  meets c->damage.  The GC's delta clip list is replaced by the damage.
+ */
+static void RepaintFrame(Clock *c, const FrameAtlas *atlas, GC gc,
+                         Bool *clipped, int x, int y) {
+  if (!Overlaps(c->damage, x, y, atlas->frameWidth, atlas->frameHeight)) {
+    return;
+  }
+
+  XSetClipOrigin(c->dpy, gc, 0, 0);
+  XSetRegion(c->dpy, gc, c->damage);
+  *clipped = True;
+  CopyAtlasFrame(c, atlas, c->shownTail, gc, x, y);
 }
 
+/*
+ *  RepaintDamage - Puts back the part of c's window in c->damage as it
+ *  was last drawn, then empties the damage.  Only what the damage
+ *  touches is sent, each piece clipped to it: margins, body, hands,
+ *  tail and eyes, or the last composed frame, put through a GC clipped
+ *  to the damage so the server copies only what was exposed.
+ */
+void RepaintDamage(Clock *c) {
+  CatLayout *l = &c->layout;
+  XRectangle box;
+  int x0, y0, x1, y1;
+
+  /*
+   *  Nothing has been drawn yet to put back
+   */
+  if (c->numSegs == 0 || c->shownTail < 0) {
+    RedrawClock(c);
+  } else {
+    XSetRegion(c->dpy, c->eraseGC, c->damage);
+    FillMargins(c);
+    XSetClipMask(c->dpy, c->eraseGC, None);
+
+    if (c->shm != NULL) {
+      XClipBox(c->damage, &box);
+      x0 = max(box.x, l->x);
+      y0 = max(box.y, l->y);
+      x1 = min(box.x + box.width, l->x + l->width);
+      y1 = min(box.y + box.height, l->y + l->height);
+      if (x0 < x1 && y0 < y1) {
+        XSetClipOrigin(c->dpy, c->gc, 0, 0);
+        XSetRegion(c->dpy, c->gc, c->damage);
+        ShmFramePut(c->shm, c->window, c->gc, x0 - l->x, y0 - l->y, x1 - x0,
+                    y1 - y0, l->x, l->y);
+        XSetClipMask(c->dpy, c->gc, None);
+      }
+    } else {
+      XSetRegion(c->dpy, c->catGC, c->damage);
+      XFillRectangle(c->dpy, c->window, c->catGC, l->x, l->y, l->width,
+                     l->height);
+      XSetClipMask(c->dpy, c->catGC, None);
+
+      RepaintFrame(c, c->tailAtlas[c->level], c->tailGC, &c->tailClipped,
+                   l->x, l->y + l->tailY);
+      RepaintFrame(c, c->eyeAtlas[c->level], c->eyeGC, &c->eyeClipped,
+                   l->x + l->eyesX, l->y + l->eyesY);
+      RepaintHands(c);
+    }
+  }
+
+  XDestroyRegion(c->damage);
+  c->damage = XCreateRegion();
+}
+
+/*
+ *  HandleExpose - Collects the exposed rectangles, and repaints them
+ *  all once the last one of the batch is in.
+ */
 void HandleExpose(Widget w, XtPointer clientData, XtPointer _callData) {
+  Clock *c = (Clock *)clientData;
+  XExposeEvent *event;
+  XRectangle rect;
+  int64_t traceStart;
 
   (void *)w;
-  (void *)clientData;
 
   XmDrawingAreaCallbackStruct *callData =
       (XmDrawingAreaCallbackStruct *)_callData;
 
+  event = (XExposeEvent *)callData->event;
+  rect.x = event->x;
+  rect.y = event->y;
+  rect.width = event->width;
+  rect.height = event->height;
+  XUnionRectWithRegion(&rect, c->damage, c->damage);
+
   /*
-   *  Ignore if more expose events for this window in the queue
+   *  Wait for the rest of the exposes for this window in the queue
    */
-  if (((XExposeEvent *)(callData->event))->count > 0) {
+  if (event->count > 0) {
     return;
   }
 
-  /*
-   *  Redraw the clock face in the correct mode
-   */
+  metrics.exposeRepaints++;
+  traceStart = TraceBegin();
+  RepaintDamage(c);
+  TraceEnd("HandleExpose", traceStart, ClockTrack(c));
+}
+
+/*
+ *  HandleResize - Refits the cat to the new size of the window.  A
+ *  window that shrank gets no expose, so everything is drawn here.
+ */
+void HandleResize(Widget w, XtPointer clientData, XtPointer callData) {
+  Clock *c = (Clock *)clientData;
+  Dimension width, height;
+
+  (void *)callData;
+
+  if (c->catGC == NULL) {
+    return;
+  }
+
+  XtVaGetValues(w, XmNwidth, &width, XmNheight, &height, NULL);
+  if (width == c->width && height == c->height) {
+    return;
+  }
 
-  DrawClockFace();
+  LayoutClock(c, width, height);
+  DrawClockFace(c);
+  if (!paused && !ClockHidden(c)) {
+    RedrawClock(c);
+  }
+}
+
+void HandleProperty(Widget w, XtPointer clientData, XEvent *event,
+                    Boolean *continueToDispatch) {
+  (void *)w;
+  (void *)continueToDispatch;
+
+  PresentFenceEvent(((Clock *)clientData)->present, event);
 }
 
 void ExitCallback(Widget w, XtPointer clientData, XtPointer callData) {
@@ -967,77 +2103,322 @@ void HandleInput(Widget w, XtPointer clientData, XtPointer _callData) {
   }
 }
 
-int main(int argc, char **argv) {
-  int n;
-  Arg args[10];
-  Widget topLevel, canvas;
-  XGCValues gcv;
-  u_long valueMask;
+/*
+ *  BenchmarkColorize - Times frames builds of body, scale times natural
+ *  size, with each body colorizer kernel this CPU can run.
+ */
+void BenchmarkColorize(RasterImage *body, double scale,
+                       const CatColors *colors, int frames) {
+  static const char *kernels[] = {"scalar", "sse2", "avx2"};
+  RasterBitmap *back, *white, *tie;
+  ColorizeColors bodyColors;
+  LatencyStats stats;
+  int64_t start, t0;
+  char label[32];
+  int k, i;
+
+  back = CatScaledBitmap(catback_bits, catback_width, catback_height, scale);
+  white =
+      CatScaledBitmap(catwhite_bits, catwhite_width, catwhite_height, scale);
+  tie = CatScaledBitmap(cattie_bits, cattie_width, cattie_height, scale);
+
+  bodyColors.background = colors->background;
+  bodyColors.catColor = colors->catColor;
+  bodyColors.detailColor = colors->detailColor;
+  bodyColors.tieColor = colors->tieColor;
+
+  for (k = 0; k < (int)XtNumber(kernels); k++) {
+    if (!ColorizeUseKernel(kernels[k])) {
+      continue;
+    }
+
+    LatencyInit(&stats, frames);
+    start = TimingNow();
+    for (i = 0; i < frames; i++) {
+      t0 = TimingNow();
+      ColorizeBody(body, back, white, tie, &bodyColors);
+      LatencyAdd(&stats, (TimingNow() - t0) / 1e6);
+    }
+    sprintf(label, "body/%s", kernels[k]);
+    LatencyReport(stdout, label, &stats, TimingNow() - start);
+    LatencyFree(&stats);
+  }
+  ColorizeUseKernel(NULL);
 
-  static XtResource resources[] = {
-      {XtNfont, XtCFont, XtRFontStruct, sizeof(XFontStruct *),
-       XtOffset(ApplicationDataPtr, font), XtRString,
-       (XtPointer)DEF_DIGITAL_FONT},
+  RasterBitmapDestroy(back);
+  RasterBitmapDestroy(white);
+  RasterBitmapDestroy(tie);
+}
 
-      {XtNforeground, XtCForeground, XtRPixel, sizeof(Pixel),
-       XtOffset(ApplicationDataPtr, foreground), XtRString,
-       (XtPointer) "XtdefaultForeground"},
+/*
+ *  RunHeadless - Renders the current time with the software renderer,
+ *  without opening a display, and writes it to path ("-" for stdout)
+ *  as a PPM.  The tail is drawn hanging straight down.
+ *
+ *  If frames is positive, the tail and eye frames are all built, and
+ *  frames bodies and frames frames composed back to back first, and
+ *  the cost reported.
+ *  The cat is drawn scale times its natural size.
+ */
+int RunHeadless(const char *path, int frames, double scale) {
+  CatColors colors;
+  CatHands hands;
+  CatLayout layout;
+  RasterImage *body, *frame;
+  RasterBitmap *tail, *eyes;
+  long nsec;
+  double t;
+  FILE *fp;
+  int status = 0;
+
+  CatDefaultColors(&colors);
+  CatSetLayout(&layout, scale, 0, 0);
+  CatSetHands(&hands, layout.width, layout.height,
+              Round(DEF_ANALOG_PADDING * scale));
+
+  WallClockNow(&tm, &nsec);
+  if (tm.tm_hour > 12) {
+    tm.tm_hour -= 12;
+  }
 
-      {XtNbackground, XtCBackground, XtRPixel, sizeof(Pixel),
-       XtOffset(ApplicationDataPtr, background), XtRString,
-       (XtPointer) "XtdefaultBackground"},
+  t = (DEF_N_TAILS / 2) * M_PI / DEF_N_TAILS;
+
+  body = CatRenderBody(&colors, scale);
+  tail = CatRenderTail(t, scale);
+  eyes = CatRenderEyes(t, scale);
+  frame = RasterImageCreate(layout.width, layout.height);
+
+  if (frames > 0) {
+    FrameSet *frameSet;
+    LatencyStats stats;
+    int64_t start, t0;
+    int i, curTail;
+
+    start = TimingNow();
+    frameSet = FrameSetCreate(DEF_N_TAILS, scale);
+    FrameSetRenderAll(frameSet);
+    printf("%-10s %6d frames in %8.3f s\n", "generate", 2 * (DEF_N_TAILS + 1),
+           (TimingNow() - start) / 1e9);
+
+    BenchmarkColorize(body, scale, &colors, frames);
+
+    LatencyInit(&stats, frames);
+    start = TimingNow();
+    for (i = 0; i < frames; i++) {
+      curTail = i % (2 * DEF_N_TAILS);
+      curTail = curTail > DEF_N_TAILS ? 2 * DEF_N_TAILS - curTail : curTail;
+
+      t0 = TimingNow();
+      CatRenderFrame(frame, body, FrameSetTail(frameSet, curTail),
+                     FrameSetEyes(frameSet, curTail), &colors, &hands,
+                     &layout, &tm);
+      LatencyAdd(&stats, (TimingNow() - t0) / 1e6);
+    }
+    LatencyReport(stdout, "headless", &stats, TimingNow() - start);
+    LatencyFree(&stats);
 
-      {"highlight", "HighlightColor", XtRPixel, sizeof(Pixel),
-       XtOffset(ApplicationDataPtr, highlightColor), XtRString,
-       (XtPointer) "XtdefaultForeground"},
+    FrameSetDestroy(frameSet);
+  }
 
-      {"hands", "Hands", XtRPixel, sizeof(Pixel),
-       XtOffset(ApplicationDataPtr, handColor), XtRString,
-       (XtPointer) "XtdefaultForeground"},
+  CatRenderFrame(frame, body, tail, eyes, &colors, &hands, &layout, &tm);
 
-      {"catColor", "CatColor", XtRPixel, sizeof(Pixel),
-       XtOffset(ApplicationDataPtr, catColor), XtRString,
-       (XtPointer) "XtdefaultForeground"},
+  if (path != NULL) {
+    fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+    if (fp == NULL) {
+      perror(path);
+      return (1);
+    }
+    status = RasterWritePPM(frame, fp);
+    if (fp != stdout) {
+      fclose(fp);
+    }
+  }
 
-      {"detailColor", "DetailColor", XtRPixel, sizeof(Pixel),
-       XtOffset(ApplicationDataPtr, detailColor), XtRString,
-       (XtPointer) "XtdefaultBackground"},
+  RasterImageDestroy(frame);
+  RasterImageDestroy(body);
+  RasterBitmapDestroy(tail);
+  RasterBitmapDestroy(eyes);
 
-      {"tieColor", "TieColor", XtRPixel, sizeof(Pixel),
-       XtOffset(ApplicationDataPtr, tieColor), XtRString,
-       (XtPointer) "XtdefaultBackground"},
+  return (status == 0 ? 0 : 1);
+}
 
-      {"padding", "Padding", XtRInt, sizeof(int),
-       XtOffset(ApplicationDataPtr, padding), XtRImmediate, (XtPointer)UNINIT},
+/*
+ *  Resources user can set in addition to normal Xt resources
+ */
+static XtResource resources[] = {
+    {XtNfont, XtCFont, XtRFontStruct, sizeof(XFontStruct *),
+     XtOffset(ApplicationDataPtr, font), XtRString,
+     (XtPointer)DEF_DIGITAL_FONT},
 
-      {"chime", "Chime", XtRBoolean, sizeof(Boolean),
-       XtOffset(ApplicationDataPtr, chime), XtRImmediate, (XtPointer)False},
+    {XtNforeground, XtCForeground, XtRPixel, sizeof(Pixel),
+     XtOffset(ApplicationDataPtr, foreground), XtRString,
+     (XtPointer) "XtdefaultForeground"},
 
-      {"help", "Help", XtRBoolean, sizeof(Boolean),
-       XtOffset(ApplicationDataPtr, help), XtRImmediate, (XtPointer)False},
-  };
+    {XtNbackground, XtCBackground, XtRPixel, sizeof(Pixel),
+     XtOffset(ApplicationDataPtr, background), XtRString,
+     (XtPointer) "XtdefaultBackground"},
 
-  argv[0] = "xclock";
+    {"highlight", "HighlightColor", XtRPixel, sizeof(Pixel),
+     XtOffset(ApplicationDataPtr, highlightColor), XtRString,
+     (XtPointer) "XtdefaultForeground"},
 
-  topLevel = XtAppInitialize(&appContext, "Catclock", NULL, 0, &argc, argv,
-                             NULL, NULL, 0);
+    {"hands", "Hands", XtRPixel, sizeof(Pixel),
+     XtOffset(ApplicationDataPtr, handColor), XtRString,
+     (XtPointer) "XtdefaultForeground"},
 
-  XtGetApplicationResources(topLevel, &appData, resources, XtNumber(resources),
-                            NULL, 0);
+    {"catColor", "CatColor", XtRPixel, sizeof(Pixel),
+     XtOffset(ApplicationDataPtr, catColor), XtRString,
+     (XtPointer) "XtdefaultForeground"},
+
+    {"detailColor", "DetailColor", XtRPixel, sizeof(Pixel),
+     XtOffset(ApplicationDataPtr, detailColor), XtRString,
+     (XtPointer) "XtdefaultBackground"},
+
+    {"tieColor", "TieColor", XtRPixel, sizeof(Pixel),
+     XtOffset(ApplicationDataPtr, tieColor), XtRString,
+     (XtPointer) "XtdefaultBackground"},
+
+    {"padding", "Padding", XtRInt, sizeof(int),
+     XtOffset(ApplicationDataPtr, padding), XtRImmediate, (XtPointer)UNINIT},
+
+    {"nTails", "NTails", XtRInt, sizeof(int),
+     XtOffset(ApplicationDataPtr, nTails), XtRImmediate,
+     (XtPointer)DEF_N_TAILS},
+
+    {"fps", "Fps", XtRInt, sizeof(int), XtOffset(ApplicationDataPtr, fps),
+     XtRImmediate, (XtPointer)0},
+
+    {"bandwidth", "Bandwidth", XtRInt, sizeof(int),
+     XtOffset(ApplicationDataPtr, bandwidth), XtRImmediate, (XtPointer)0},
+
+    {"chime", "Chime", XtRBoolean, sizeof(Boolean),
+     XtOffset(ApplicationDataPtr, chime), XtRImmediate, (XtPointer)False},
+
+    {"help", "Help", XtRBoolean, sizeof(Boolean),
+     XtOffset(ApplicationDataPtr, help), XtRImmediate, (XtPointer)False},
+
+    {"framesInFlight", "FramesInFlight", XtRInt, sizeof(int),
+     XtOffset(ApplicationDataPtr, framesInFlight), XtRImmediate,
+     (XtPointer)DEF_FRAMES_IN_FLIGHT},
+
+    {"shm", "Shm", XtRBoolean, sizeof(Boolean),
+     XtOffset(ApplicationDataPtr, shm), XtRImmediate, (XtPointer)False},
+
+    {"governor", "Governor", XtRBoolean, sizeof(Boolean),
+     XtOffset(ApplicationDataPtr, governor), XtRImmediate, (XtPointer)True},
+
+    {"share", "Share", XtRBoolean, sizeof(Boolean),
+     XtOffset(ApplicationDataPtr, share), XtRImmediate, (XtPointer)True},
+
+    {"renderAhead", "RenderAhead", XtRBoolean, sizeof(Boolean),
+     XtOffset(ApplicationDataPtr, renderAhead), XtRImmediate,
+     (XtPointer)False},
+
+    {"control", "Control", XtRString, sizeof(char *),
+     XtOffset(ApplicationDataPtr, control), XtRImmediate, (XtPointer)NULL},
+
+    {"trace", "Trace", XtRString, sizeof(char *),
+     XtOffset(ApplicationDataPtr, trace), XtRImmediate, (XtPointer)NULL},
+
+    {"copyMode", "CopyMode", XtRString, sizeof(char *),
+     XtOffset(ApplicationDataPtr, copyMode), XtRImmediate,
+     (XtPointer)"auto"},
+
+    {"scale", "Scale", XtRFloat, sizeof(float),
+     XtOffset(ApplicationDataPtr, scale), XtRString, (XtPointer)"0"},
+
+    {"seconds", "Seconds", XtRString, sizeof(char *),
+     XtOffset(ApplicationDataPtr, seconds), XtRImmediate,
+     (XtPointer)"none"},
+
+    {"displays", "Displays", XtRString, sizeof(char *),
+     XtOffset(ApplicationDataPtr, displays), XtRImmediate, (XtPointer)NULL},
+
+    {"allScreens", "AllScreens", XtRBoolean, sizeof(Boolean),
+     XtOffset(ApplicationDataPtr, allScreens), XtRImmediate,
+     (XtPointer)False},
+
+    {"benchmark", "Benchmark", XtRInt, sizeof(int),
+     XtOffset(ApplicationDataPtr, benchmark), XtRImmediate, (XtPointer)0},
+
+    {"benchmarkRate", "BenchmarkRate", XtRInt, sizeof(int),
+     XtOffset(ApplicationDataPtr, benchmarkRate), XtRImmediate,
+     (XtPointer)0},
+};
+
+/*
+ *  AddClock - Adds a clock on screen of dpy, shown in shell, or in a new
+ *  shell on that screen if shell is NULL.
+ */
+void AddClock(Widget shell, Display *dpy, int screen) {
+  Clock *c;
+
+  if (shell == NULL) {
+    Arg args[1];
+
+    XtSetArg(args[0], XtNscreen, ScreenOfDisplay(dpy, screen));
+    shell = XtAppCreateShell(NULL, "Catclock", applicationShellWidgetClass,
+                             dpy, args, 1);
+  }
+
+  clocks = (Clock *)realloc(clocks, (nClocks + 1) * sizeof(Clock));
+  c = &clocks[nClocks++];
+  memset(c, 0, sizeof(Clock));
+
+  c->dpy = dpy;
+  c->screen = screen;
+  c->root = RootWindow(dpy, screen);
+  c->topLevel = shell;
+  c->shownTail = -1;
+  c->level = DEF_LEVEL;
+
+  /*
+   *  The first clock on a display rings the chime there
+   */
+  c->bell = c == clocks || clocks[nClocks - 2].dpy != dpy;
+}
+
+/*
+ *  AddClocks - Adds the clocks of one display: its default screen,
+ *  shown in shell if that is not NULL, and with allScreens the rest.
+ */
+void AddClocks(Widget shell, Display *dpy) {
+  int screen;
+
+  MetricsWatchDisplay(dpy);
+  AddClock(shell, dpy, DefaultScreen(dpy));
 
-  dpy = XtDisplay(topLevel);
-  screen = DefaultScreen(dpy);
-  root = DefaultRootWindow(dpy);
+  if (appData.allScreens) {
+    for (screen = 0; screen < ScreenCount(dpy); screen++) {
+      if (screen != DefaultScreen(dpy)) {
+        AddClock(NULL, dpy, screen);
+      }
+    }
+  }
+}
+
+/*
+ *  InitializeClock - Realizes c's window and creates everything it
+ *  draws with.  Colors are looked up again for every clock, since each
+ *  display has its own colormap.
+ */
+void InitializeClock(Clock *c) {
+  int n;
+  Arg args[10];
+  XGCValues gcv;
+  u_long valueMask;
+
+  XtGetApplicationResources(c->topLevel, &c->res, resources,
+                            XtNumber(resources), NULL, 0);
 
   /*
    *  "ParseGeometry"  looks at the user-specified geometry
    *  specification string, and attempts to apply it in a rational
    *  fashion to the clock in whatever mode it happens to be in.
-   *  For example, for analog mode, any sort of geometry is OK, but
-   *  the cat must be a certain size, although the x and y origins
-   *  should not be ignored, etc.
+   *  The cat is fitted to whatever size results, so only the
+   *  default size depends on the screen.
    */
-  ParseGeometry(topLevel);
+  ParseGeometry(c->topLevel, ScreenScale(c));
 
   /*
    *  "canvas" is the display widget
@@ -1052,22 +2433,22 @@ int main(int argc, char **argv) {
   n++;
   XtSetArg(args[n], XmNrightAttachment, XmATTACH_FORM);
   n++;
-  XtSetArg(args[n], XmNforeground, appData.foreground);
+  XtSetArg(args[n], XmNforeground, c->res.foreground);
   n++;
-  XtSetArg(args[n], XmNbackground, appData.background);
+  XtSetArg(args[n], XmNbackground, c->res.background);
   n++;
-  canvas = XmCreateDrawingArea(topLevel, "drawingArea", args, n);
-  XtManageChild(canvas);
+  c->canvas = XmCreateDrawingArea(c->topLevel, "drawingArea", args, n);
+  XtManageChild(c->canvas);
 
   /*
    *  Make all the windows, etc.
    */
-  XtRealizeWidget(topLevel);
+  XtRealizeWidget(c->topLevel);
 
   /*
    *  Cache the window associated with the XmDrawingArea
    */
-  clockWindow = XtWindow(canvas);
+  c->window = XtWindow(c->canvas);
 
   /*
    *  Create the GC's
@@ -1076,59 +2457,226 @@ int main(int argc, char **argv) {
                GCGraphicsExposures) &
               ~GCFont;
 
-  gcv.background = appData.background;
-  gcv.foreground = appData.foreground;
+  gcv.background = c->res.background;
+  gcv.foreground = c->res.foreground;
 
   gcv.graphics_exposures = False;
   gcv.line_width = 0;
 
-  gc = XCreateGC(dpy, clockWindow, valueMask, &gcv);
+  c->gc = XCreateGC(c->dpy, c->window, valueMask, &gcv);
 
   valueMask = GCForeground | GCLineWidth;
-  gcv.foreground = appData.background;
-  eraseGC = XCreateGC(dpy, clockWindow, valueMask, &gcv);
+  gcv.foreground = c->res.background;
+  c->eraseGC = XCreateGC(c->dpy, c->window, valueMask, &gcv);
 
-  gcv.foreground = appData.highlightColor;
-  highGC = XCreateGC(dpy, clockWindow, valueMask, &gcv);
+  gcv.foreground = c->res.highlightColor;
+  c->highGC = XCreateGC(c->dpy, c->window, valueMask, &gcv);
 
   valueMask = GCForeground;
-  gcv.foreground = appData.handColor;
-  handGC = XCreateGC(dpy, clockWindow, valueMask, &gcv);
+  gcv.foreground = c->res.handColor;
+  c->handGC = XCreateGC(c->dpy, c->window, valueMask, &gcv);
 
-  appData.nTails = DEF_N_TAILS;
-  appData.padding = DEF_ANALOG_PADDING;
+  c->damage = XCreateRegion();
+
+  InitializeCat(c);
+
+  {
+    XtAddCallback(c->canvas, XmNexposeCallback, HandleExpose, c);
+    XtAddCallback(c->canvas, XmNinputCallback, HandleInput, c);
+    XtAddCallback(c->canvas, XmNresizeCallback, HandleResize, c);
+    XtAddEventHandler(c->canvas, PropertyChangeMask, False, HandleProperty,
+                      c);
+    XtAddEventHandler(c->canvas, VisibilityChangeMask, False,
+                      HandleVisibility, c);
+    XtAddEventHandler(c->topLevel, StructureNotifyMask, False,
+                      HandleStructure, c);
+  }
+
+  c->present = PresentCreate(c->dpy, c->window, c->res.framesInFlight);
+  c->present->traceTrack = ClockTrack(c);
+
+  /*
+   *  Client side compositing only pays off, and only works, when the
+   *  server can map our memory; otherwise keep drawing with requests.
+   */
+  if (appData.shm && !InitializeShm(c)) {
+    fprintf(stderr, "xclock: MIT-SHM unavailable on %s, drawing on the "
+                    "server\n",
+            DisplayString(c->dpy));
+  }
+
+  GovernorInit(&c->governor, N_LEVELS, DEF_LEVEL);
+
+  c->mapped = True;
+}
+
+int main(int argc, char **argv) {
+  int n, i;
+  Widget topLevel;
+
+  static XrmOptionDescRec options[] = {
+      {"-benchmark", "*benchmark", XrmoptionSepArg, NULL},
+      {"--benchmark", "*benchmark", XrmoptionSepArg, NULL},
+      {"-benchmarkRate", "*benchmarkRate", XrmoptionSepArg, NULL},
+      {"-shm", "*shm", XrmoptionNoArg, "True"},
+      {"-tails", "*nTails", XrmoptionSepArg, NULL},
+      {"-fps", "*fps", XrmoptionSepArg, NULL},
+      {"-bandwidth", "*bandwidth", XrmoptionSepArg, NULL},
+      {"-nogovernor", "*governor", XrmoptionNoArg, "False"},
+      {"-noshare", "*share", XrmoptionNoArg, "False"},
+      {"-renderAhead", "*renderAhead", XrmoptionNoArg, "True"},
+      {"-scale", "*scale", XrmoptionSepArg, NULL},
+      {"-copyMode", "*copyMode", XrmoptionSepArg, NULL},
+      {"-seconds", "*seconds", XrmoptionSepArg, NULL},
+      {"-trace", "*trace", XrmoptionSepArg, NULL},
+      {"-control", "*control", XrmoptionSepArg, NULL},
+      {"-displays", "*displays", XrmoptionSepArg, NULL},
+      {"-allScreens", "*allScreens", XrmoptionNoArg, "True"},
+  };
 
   /*
-   *  Update rate depends on number of tails,
-   *  so tail swings at approximately 60 hz.
+   *  Headless rendering never touches the display, so it has to be
+   *  picked out before Xt tries to open one.
    */
-  appData.update = (int)(1000.0 / appData.nTails);
+  for (n = 1; n < argc; n++) {
+    if (strcmp(argv[n], "-headless") == 0) {
+      char *path = NULL;
+      int frames = 0;
+      double scale = 1.0;
+      int i;
+
+      if (n + 1 < argc && (argv[n + 1][0] != '-' || argv[n + 1][1] == '\0')) {
+        path = argv[n + 1];
+      }
+      for (i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "-benchmark") == 0 ||
+            strcmp(argv[i], "--benchmark") == 0) {
+          frames = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-scale") == 0 && atof(argv[i + 1]) > 0) {
+          scale = atof(argv[i + 1]);
+        }
+      }
+      return (RunHeadless(path, frames, scale));
+    }
+
+    if (strcmp(argv[n], "-export") == 0 && n + 1 < argc) {
+      ExportOptions export;
+      int i;
+
+      memset(&export, 0, sizeof(export));
+      export.path = argv[n + 1];
+      export.start = time(NULL);
+      export.duration = 60;
+      export.fps = 30;
+      export.scale = 1.0;
+      export.nTails = DEF_N_TAILS;
+      export.secondHand = SECONDS_NONE;
+      for (i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "-start") == 0 &&
+            ExportParseTime(argv[i + 1], &export.start) != 0) {
+          fprintf(stderr, "xclock: bad -start time \"%s\"\n", argv[i + 1]);
+          return (1);
+        } else if (strcmp(argv[i], "-duration") == 0) {
+          export.duration = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "-fps") == 0) {
+          export.fps = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-threads") == 0) {
+          export.threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-scale") == 0 && atof(argv[i + 1]) > 0) {
+          export.scale = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "-tails") == 0 && atoi(argv[i + 1]) > 0) {
+          export.nTails = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-seconds") == 0 &&
+                   strcmp(argv[i + 1], "sweep") == 0) {
+          export.secondHand = SECONDS_SWEEP;
+        } else if (strcmp(argv[i], "-seconds") == 0 &&
+                   strcmp(argv[i + 1], "tick") == 0) {
+          export.secondHand = SECONDS_TICK;
+        }
+      }
+      export.padding = Round(DEF_ANALOG_PADDING * export.scale);
+      return (Export(&export));
+    }
+  }
+
+  argv[0] = "xclock";
+
+  topLevel = XtAppInitialize(&appContext, "Catclock", options,
+                             XtNumber(options), &argc, argv, NULL, NULL, 0);
+
+  XtGetApplicationResources(topLevel, &appData, resources, XtNumber(resources),
+                            NULL, 0);
+
+  BudgetInit(&budget, N_LEVELS, appData.bandwidth);
+  metrics.budget = budget.budget;
+  SetTails(appData.nTails < 1 ? DEF_N_TAILS : appData.nTails);
+  shareTails = levels[DEF_LEVEL].nTails;
+
+  if (strcmp(appData.seconds, "sweep") == 0) {
+    secondHand = SECONDS_SWEEP;
+  } else if (strcmp(appData.seconds, "tick") == 0) {
+    secondHand = SECONDS_TICK;
+  } else if (strcmp(appData.seconds, "none") != 0) {
+    fprintf(stderr, "xclock: unknown seconds %s, use none, tick or sweep\n",
+            appData.seconds);
+  }
 
   /*
    *  Set the sizes of the hands for analog and cat mode
    */
+  appData.padding = DEF_ANALOG_PADDING;
 
-  radius = Round((min(DEF_CAT_WIDTH, DEF_CAT_HEIGHT) - (2 * appData.padding)) /
-                 3.45);
+  if (appData.trace != NULL) {
+    TraceStart(appContext, appData.trace);
+  }
+  if (appData.control != NULL) {
+    ControlStart(appContext, appData.control, ControlCommand);
+  }
 
-  secondHandLength = ((SECOND_HAND_FRACT * radius) / 100);
-  minuteHandLength = ((MINUTE_HAND_FRACT * radius) / 100);
-  hourHandLength = ((HOUR_HAND_FRACT * radius) / 100);
+  swingEpoch = TimingNow();
+
+  /*
+   *  One clock on the default screen, or on every screen, of the
+   *  display Xt opened and of each of the extra displays.
+   */
+  AddClocks(topLevel, XtDisplay(topLevel));
+  if (appData.displays != NULL) {
+    char *names = strdup(appData.displays);
+    char *name;
+
+    for (name = strtok(names, " ,"); name != NULL;
+         name = strtok(NULL, " ,")) {
+      int zero = 0;
+      Display *dpy = XtOpenDisplay(appContext, name, "xclock", "Catclock",
+                                   NULL, 0, &zero, NULL);
+
+      if (dpy == NULL) {
+        fprintf(stderr, "xclock: can't open display %s\n", name);
+        continue;
+      }
+      AddClocks(NULL, dpy);
+    }
+    free(names);
+  }
 
-  handWidth = ((HAND_WIDTH_FRACT * radius) / 100) * 2;
-  secondHandWidth = ((SECOND_WIDTH_FRACT * radius) / 100);
+  for (i = 0; i < nClocks; i++) {
+    InitializeClock(&clocks[i]);
+  }
 
-  centerX = DEF_CAT_WIDTH / 2;
-  centerY = DEF_CAT_HEIGHT / 2;
+  if (appData.benchmark > 0) {
+    RunBenchmark(&clocks[0], appData.benchmark, appData.benchmarkRate);
+    return 0;
+  }
 
-  InitializeCat(appData.catColor, appData.detailColor, appData.tieColor);
+  Tick(NULL, 0, False);
+  SchedStart(appContext, FramePeriod(), Tick, NULL);
 
-  {
-    XtAddCallback(canvas, XmNexposeCallback, HandleExpose, NULL);
-    XtAddCallback(canvas, XmNinputCallback, HandleInput, NULL);
+  if (appData.renderAhead) {
+    ahead = RenderAheadStart(nClocks, PlanAhead, NULL);
   }
 
-  Tick(canvas, True);
+  XtAppAddTimeOut(appContext, BLANK_POLL_INTERVAL, PollBlank, NULL);
+
   XtAppMainLoop(appContext);
 
   return 0;